@@ -0,0 +1,7 @@
+#include "sceneHost.h"
+#include "scenes.h"
+
+int main(int argc, char const *argv[])
+{
+    return runScene(argc, argv, "Morph", {"Morph", createMorphScene});
+}
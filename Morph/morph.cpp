@@ -0,0 +1,77 @@
+#include <glad/glad.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm/glm.hpp>
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+#include "Morph.h"
+#include "scene.h"
+
+namespace {
+    // A triangle morphing into a quad and back
+    class MorphScene : public Scene
+    {
+    public:
+        bool setup(SceneResources &resources, const std::vector<std::string> &arguments) override;
+        // triangle -> hold -> quad -> hold
+        double duration() const override { return 2.0f * (morphDuration + holdDuration); }
+        void render(SceneResources &resources, double time) override;
+        void release() override;
+
+    private:
+        MorphMesh morph;
+        float morphDuration = 2.0f;
+        float holdDuration = 1.0f;
+    };
+
+    bool MorphScene::setup(SceneResources &resources, const std::vector<std::string> &arguments)
+    {
+        glEnable(GL_MULTISAMPLE);
+
+        // Same outlines as the TriangleLines and Quad demos
+        std::vector<glm::vec2> triangle = {
+            {-0.5f, -0.5f}, {0.0f, 0.5f}, {0.5f, -0.5f}
+        };
+        std::vector<glm::vec2> quad = {
+            {-0.25f, 0.5f}, {0.25f, 0.5f}, {0.25f, -0.5f}, {-0.25f, -0.5f}
+        };
+
+        // All correspondence work happens here, rendering only updates the blend factor
+        return morph.setup(triangle, quad, 96);
+    }
+
+    void MorphScene::render(SceneResources &resources, double time)
+    {
+        glClearColor(0.10, 0.10, 0.10, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // triangle -> hold -> quad -> hold -> triangle ...
+        float cycle = 2.0f * (morphDuration + holdDuration);
+        float local = std::fmod(static_cast<float>(time), cycle);
+        float t = glm::clamp(local / morphDuration, 0.0f, 1.0f);
+        if (local > morphDuration + holdDuration)
+            t = 1.0f - glm::clamp((local - morphDuration - holdDuration) / morphDuration, 0.0f, 1.0f);
+        float blend = glm::smoothstep(0.0f, 1.0f, t);
+
+        morph.drawFill(blend, glm::vec4(1.0f, 0.5f, 0.2f, 0.35f));
+        morph.drawOutline(blend, glm::vec4(1.0f, 0.5f, 0.2f, 1.0f));
+    }
+
+    void MorphScene::release()
+    {
+        morph.release();
+    }
+}
+
+std::unique_ptr<Scene> createMorphScene()
+{
+    return std::make_unique<MorphScene>();
+}
+
+SCENE_PLUGIN_ENTRY(createMorphScene)
@@ -2,16 +2,12 @@
 #include <GL/gl.h>
 #include <GL/glext.h>
 #include <GLFW/glfw3.h>
-#include "textRenderer.h"
 #include <glm/glm/glm.hpp>
 #include <glm/glm/gtx/io.hpp>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm/ext.hpp>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include <filesystem>
 #include <map>
 #include <vector>
@@ -22,262 +18,174 @@
 #include <string>
 #include <sstream>
 
-#include "GlfwWindowUtils.h"
+#include "CoordinateTransform.h"
+#include "LayerCache.h"
+#include "scene.h"
 #include "textRenderer.h"
 #include "utils.h"
 
-#define WINDOW_WIDTH 1920.0
-#define WINDOW_HEIGTH 1080.0
-
-TextRenderer textRenderer;
-std::map<GLchar, Character> Characters;
-GLuint textVAO, textVBO;
-
-float mapValue(float x, float inMin, float inMax, float outMin, float outMax) {
-    float t = (x - inMin) / (inMax - inMin);
-    return glm::mix(outMin, outMax, t);
-}
-
-int main(int argc, char const *argv[])
-{
-    glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_SAMPLES, 8);
-
-    GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGTH, "Triangle Points", NULL, NULL);
-	if(window == NULL){
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-    
-    glfwMakeContextCurrent(window);
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)){
-		std::cout << "Failed to initialize GLAD" << std::endl;
-		return -1;
-	}
-
-    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGTH);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glEnable(GL_MULTISAMPLE);
-    
-    const char* vertexShaderSource = R"(
-        #version 330 core
-        layout (location = 0) in vec3 aPos;
-        void main() {
-            gl_Position = vec4(aPos, 1.0);
-            gl_PointSize = 15.0f; // Size in pixels
-        }
-    )";
-
-    const char* fragmentShaderSource = R"(
-        #version 330 core
-        out vec4 FragColor;
-        void main() {
-            FragColor = vec4(1.0, 0.5, 0.2, 1.0); // orange
-        }
-    )";
-    
-        // 1. Compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-
-    // 2. Compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-
-    // 3. Link shaders into program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // FreeType
-    // --------
-    FT_Library ft;
-    // All functions return a value different than 0 whenever an error occurred
-    if (FT_Init_FreeType(&ft))
+namespace {
+    // A quad drawn edge by edge along with its diagonal, then filled one triangle at a time
+    class QuadScene : public Scene
     {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return -1;
-    }
-
-	// find path to font
-    std::string font_name = std::string(RESOURCE_PATH) + "/CuteFont-Regular.ttf";
-    if (font_name.empty())
-    {
-        std::cout << "ERROR::FREETYPE: Failed to load font_name" << std::endl;
-        return -1;
-    }
-	
-	// load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, font_name.c_str(), 0, &face)) {
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        return -1;
-    }
-    else {
-        // set size to load glyphs as
-        FT_Set_Pixel_Sizes(face, 0, 48);
-
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-        // load first 128 characters of ASCII set
-        for (unsigned char c = 0; c < 128; c++)
-        {
-            // Load character glyph 
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-            {
-                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-                continue;
-            }
-            // generate texture
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-            // set texture options
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            // now store character for later use
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                static_cast<unsigned int>(face->glyph->advance.x)
-            };
-            Characters.insert(std::pair<char, Character>(c, character));
-        }
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-
-
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    glm::vec3 topRight = glm::vec3(0.25f, 0.5f, 0.0f);
-    glm::vec3 topLeft = glm::vec3(-0.25f, 0.5f, 0.0f);
-    glm::vec3 bottomRight = glm::vec3(0.25f, -0.5f, 0.0f);
-    glm::vec3 bottomLeft = glm::vec3(-0.25f, -0.5f, 0.0f);
-
-    // Text of Points
-    
-    std::string topRightText, topLeftText, bottomRightText, bottomLeftText;
-    unsigned int precisionVal = 1;
-
-    glm::vec3 topRightTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 topLeftTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
-
-    float offsetTopX = 0.075f;
-    float offsetTopY = 0.090f;
-
-    topRightTextCoords.x = mapValue(topRight.x - offsetTopX, -1.0f, 1.0f, 0.0f, 1920.0f);
-    topRightTextCoords.y = mapValue(topRight.y + offsetTopY, -1.0f, 1.0f, 0.0f, 1080.0f);
-    topRightText         = glmToText(topRight, precisionVal);
-
-    topLeftTextCoords.x = mapValue(topLeft.x - offsetTopX, -1.0f, 1.0f, 0.0f, 1920.0f);
-    topLeftTextCoords.y = mapValue(topLeft.y + offsetTopY, -1.0f, 1.0f, 0.0f, 1080.0f);
-    topLeftText         = glmToText(topLeft, precisionVal);
+    public:
+        bool setup(SceneResources &resources, const std::vector<std::string> &arguments) override;
+        double duration() const override { return totalAnimDuration; }
+        bool isUnchanged(double time) override;
+        void render(SceneResources &resources, double time) override;
+        void release() override;
+
+    private:
+        // Places the labels in framebuffer pixels for the current size
+        void placeLabels(int width, int height);
+
+        const ShaderProgram *pointsProgram = nullptr;
+        TextRenderer *textRenderer = nullptr;
+
+        glm::vec3 topRight = glm::vec3(0.25f, 0.5f, 0.0f);
+        glm::vec3 topLeft = glm::vec3(-0.25f, 0.5f, 0.0f);
+        glm::vec3 bottomRight = glm::vec3(0.25f, -0.5f, 0.0f);
+        glm::vec3 bottomLeft = glm::vec3(-0.25f, -0.5f, 0.0f);
+
+        std::string topRightText, topLeftText, bottomRightText, bottomLeftText;
+        glm::vec3 topRightTextCoords, topLeftTextCoords, bottomRightTextCoords, bottomLeftTextCoords;
+        int labelWidth = 0, labelHeight = 0;
+        unsigned int precisionVal = 1;
 
+        float totalAnimDuration = 10.0f;
+        float segmentDuration = 1.0f;
+        float pauseDuration = 3.0f;
 
-    glm::vec3 bottomRightTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 bottomLeftTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
+        GLuint VAO = 0, VBO = 0, EBO = 0, quadLineVAO = 0, quadLineVBO = 0;
 
-    float offsetbottomX = 0.100;
-    float offsetbottomY = 0.100;
+        // Refilled every frame; kept so their storage is reused
+        std::vector<glm::vec3> drawPoints, linePoints;
 
-    bottomRightTextCoords.x = mapValue(bottomRight.x - offsetbottomX, -1.0f, 1.0f, 0.0f, 1920.0f);
-    bottomRightTextCoords.y = mapValue(bottomRight.y - offsetbottomY, -1.0f, 1.0f, 0.0f, 1080.0f);
-    bottomRightText         = glmToText(bottomRight, precisionVal);
+        enum { STATIC_LAYER, LAYER_COUNT };
+        LayerCache layers;
 
-    bottomLeftTextCoords.x = mapValue(bottomLeft.x - offsetbottomX, -1.0f, 1.0f, 0.0f, 1920.0f);
-    bottomLeftTextCoords.y = mapValue(bottomLeft.y - offsetbottomY, -1.0f, 1.0f, 0.0f, 1080.0f);
-    bottomLeftText         = glmToText(bottomLeft, precisionVal);
+        unsigned int pointCounts = 0;
+        bool isAnimationFinished = false;
+        bool wasFrameStatic = false;
+    };
 
+    bool QuadScene::setup(SceneResources &resources, const std::vector<std::string> &arguments)
+    {
+        RenderContext &context = resources.context;
+        glEnable(GL_MULTISAMPLE);
+
+        // Shared with the other point scenes, edits are picked up while running
+        pointsProgram = &resources.shaders().load(std::string(SHADER_PATH) + "/points.shader");
+        textRenderer = &resources.text();
+
+        placeLabels(context.width(), context.height());
+        topRightText    = glmToText(topRight, precisionVal);
+        topLeftText     = glmToText(topLeft, precisionVal);
+        bottomRightText = glmToText(bottomRight, precisionVal);
+        bottomLeftText  = glmToText(bottomLeft, precisionVal);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        // The two fill triangles never change, upload them once
+        const unsigned int indices[] = {  // note that we start from 0!
+            0, 1, 2,
+            1, 2, 3
+        };
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glBindVertexArray(0);
 
-    float startTime = glfwGetTime();
-    unsigned int pointCounts = 0;
-    bool isAnimationFinished = false;
+        glGenVertexArrays(1, &quadLineVAO);
+        glGenBuffers(1, &quadLineVBO);
+        drawPoints.reserve(4);
+        linePoints.reserve(10);
 
-    GLuint VAO, VBO, quadLineVAO, quadLineVBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+        return layers.setup(context, LAYER_COUNT);
+    }
 
-    glGenVertexArrays(1, &quadLineVAO);
-    glGenBuffers(1, &quadLineVBO);
+    void QuadScene::placeLabels(int width, int height)
+    {
+        // Text of Points, anchored in NDC and placed in framebuffer pixels
+        float offsetTopX = 0.075f;
+        float offsetTopY = 0.090f;
+        float offsetbottomX = 0.100;
+        float offsetbottomY = 0.100;
+
+        const glm::vec2 anchors[] = {
+            glm::vec2(topRight.x - offsetTopX, topRight.y + offsetTopY),
+            glm::vec2(topLeft.x - offsetTopX, topLeft.y + offsetTopY),
+            glm::vec2(bottomRight.x - offsetbottomX, bottomRight.y - offsetbottomY),
+            glm::vec2(bottomLeft.x - offsetbottomX, bottomLeft.y - offsetbottomY),
+        };
+        glm::vec2 positions[4];
+        CoordinateTransform::ndcToPixels(width, height).apply(anchors, positions, 4);
+
+        topRightTextCoords    = glm::vec3(positions[0], 0.0f);
+        topLeftTextCoords     = glm::vec3(positions[1], 0.0f);
+        bottomRightTextCoords = glm::vec3(positions[2], 0.0f);
+        bottomLeftTextCoords  = glm::vec3(positions[3], 0.0f);
+        labelWidth = width;
+        labelHeight = height;
+    }
 
+    bool QuadScene::isUnchanged(double time)
+    {
+        // Both triangles are filled from here on and nothing moves anymore
+        bool isFrameStatic = time >= 6 * segmentDuration + pauseDuration;
+        bool unchanged = isFrameStatic && wasFrameStatic;
+        wasFrameStatic = isFrameStatic;
+        return unchanged;
+    }
 
-	while(!glfwWindowShouldClose(window)){
+    void QuadScene::render(SceneResources &resources, double time)
+    {
+        float elapsed = time;
+        // The static layer is rebuilt for the new size as well, with the labels moved
+        if (resources.context.width() != labelWidth || resources.context.height() != labelHeight)
+            placeLabels(resources.context.width(), resources.context.height());
 
         glClearColor(0.10, 0.10, 0.10, 1.0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);    
 
-        float currentTime = glfwGetTime();
-        float totalAnimDuration = 10.0f;
-        float elapsed = currentTime - startTime;
-        float segmentDuration = 1.0f;
-        std::vector<glm::vec3> drawPoints, linePoints, trianglePoints;
-
-        std::string text = "";
-        std::string topTextString = "";
-        std::string bottomRightTextString = "";
-
+        drawPoints.clear();
+        linePoints.clear();
         drawPoints.push_back(topRight);
         drawPoints.push_back(topLeft);
         drawPoints.push_back(bottomRight);
         drawPoints.push_back(bottomLeft);
         pointCounts = 4;
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, drawPoints.size() * sizeof(glm::vec3), drawPoints.data(), GL_STATIC_DRAW);
+        // The vertices and their labels never move: draw them once and composite them afterwards
+        if (layers.begin(STATIC_LAYER)) {
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBufferData(GL_ARRAY_BUFFER, drawPoints.size() * sizeof(glm::vec3), drawPoints.data(), GL_STATIC_DRAW);
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
-        glUseProgram(shaderProgram);
-        glEnableVertexAttribArray(0);
-        glEnable(GL_PROGRAM_POINT_SIZE);
-        glDrawArrays(GL_POINTS, 0, pointCounts);
+            glUseProgram(pointsProgram->id);
+            glEnableVertexAttribArray(0);
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            glDrawArrays(GL_POINTS, 0, pointCounts);
+
+            textRenderer->renderText(topRightText, topRightTextCoords.x, topRightTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
+            textRenderer->renderText(topLeftText, topLeftTextCoords.x, topLeftTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
+            textRenderer->renderText(bottomRightText, bottomRightTextCoords.x, bottomRightTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
+            textRenderer->renderText(bottomLeftText, bottomLeftTextCoords.x, bottomLeftTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
+            layers.end();
+        }
+        layers.composite(STATIC_LAYER);
 
         unsigned int lineCounts = 0;
-        float pauseDuration = 3.0f;
 
-        textRenderer.renderText(Characters, textVAO, textVBO, topRightText, topRightTextCoords.x, topRightTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        textRenderer.renderText(Characters, textVAO, textVBO, topLeftText, topLeftTextCoords.x, topLeftTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        textRenderer.renderText(Characters, textVAO, textVBO, bottomRightText, bottomRightTextCoords.x, bottomRightTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        textRenderer.renderText(Characters, textVAO, textVBO, bottomLeftText, bottomLeftTextCoords.x, bottomLeftTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
+        // Derived from the scene time rather than latched, so any frame can be rendered on its own
+        isAnimationFinished = elapsed >= 5 * segmentDuration;
 
-        float time = glm::clamp(elapsed, 0.0f, segmentDuration);
-        
         if (elapsed < segmentDuration) {
             
             linePoints.push_back(topLeft);
@@ -360,7 +268,6 @@ int main(int argc, char const *argv[])
 
             linePoints.push_back(bottomLeft);
             linePoints.push_back(bottomRight);
-            isAnimationFinished = true;
             lineCounts = 10;
         }
         
@@ -370,49 +277,38 @@ int main(int argc, char const *argv[])
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
-        glUseProgram(shaderProgram);
+        glUseProgram(pointsProgram->id);
         glEnableVertexAttribArray(0);
         glBindVertexArray(quadLineVAO);
         glDrawArrays(GL_LINES, 0, lineCounts);
 
         if (isAnimationFinished){
-            unsigned int indices[] = {  // note that we start from 0!
-                0, 1, 2,
-                1, 2, 3
-            };  
-            unsigned int EBO;
-            glGenBuffers(1, &EBO);
-
+            // The index buffer is part of the VAO since setup
             glBindVertexArray(VAO);
             glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
             glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
-            
-            if (elapsed < (6 * segmentDuration + pauseDuration)){
-                glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0);
-            }
-            else if (elapsed < (7 * segmentDuration + pauseDuration)){
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-            }
-            else {
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-            }
-        }  
-
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+            // One triangle during the pause, then both
+            GLsizei indexCount = elapsed < (6 * segmentDuration + pauseDuration) ? 3 : 6;
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
     }
 
-    glDeleteVertexArrays(1, &textVAO);
-    glDeleteBuffers(1, &textVBO);
-    glDeleteProgram(shaderProgram); 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    glfwTerminate();
-    return 0;
+    void QuadScene::release()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteVertexArrays(1, &quadLineVAO);
+        glDeleteBuffers(1, &quadLineVBO);
+        VAO = VBO = EBO = quadLineVAO = quadLineVBO = 0;
+        layers.release();
+    }
+}
+
+std::unique_ptr<Scene> createQuadScene()
+{
+    return std::make_unique<QuadScene>();
 }
 
+SCENE_PLUGIN_ENTRY(createQuadScene)
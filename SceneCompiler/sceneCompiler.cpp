@@ -0,0 +1,26 @@
+#include <iostream>
+#include <string>
+
+#include "SceneFormat.h"
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <input.scene> [output.sceneb]" << std::endl;
+        return -1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argc > 2 ? argv[2] : input + "b";
+    if (!compileScene(input, output))
+        return -1;
+
+    SceneFile scene;
+    if (!scene.open(output))
+        return -1;
+
+    std::cout << output << ": " << scene.pointCount() << " points, " << scene.polylineCount() << " polylines, "
+              << scene.labelCount() << " labels, " << scene.trackCount() << " tracks" << std::endl;
+    return 0;
+}
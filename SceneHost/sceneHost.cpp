@@ -0,0 +1,15 @@
+#include "sceneHost.h"
+#include "scenes.h"
+
+// Every demo in one process: the context, fonts and shaders are set up once
+// and the scenes named on the command line play back to back.
+int main(int argc, char const *argv[])
+{
+    const std::vector<SceneEntry> scenes = {
+        {"TrianglePoints", createTrianglePointsScene, TRIANGLE_POINTS_PLUGIN},
+        {"TriangleLines", createTriangleLinesScene, TRIANGLE_LINES_PLUGIN},
+        {"Quad", createQuadScene, QUAD_PLUGIN},
+        {"Morph", createMorphScene, MORPH_PLUGIN},
+    };
+    return runScenePlaylist(argc, argv, "Animations", scenes);
+}
@@ -0,0 +1,349 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Canvas.h"
+#include "CoordinateTransform.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "Path.h"
+#include "RenderContext.h"
+#include "scene.h"
+#include "utils.h"
+
+#define WINDOW_WIDTH 1920.0
+#define WINDOW_HEIGTH 1080.0
+
+// Procedurally generated load for finding where each part of the renderer
+// stops scaling. Every subsystem is swept over N = 1, 10, 100, ... with N
+// points, N animated lines, N labels, N points following curved paths, and
+// finally all of them at once; all drawing goes through the same Canvas calls
+// as the demos. GL runs also sweep N labels drawn glyph by glyph through the
+// TextRenderer that TrianglePoints and Quad use. Per step it
+// reports the frame time, canvas draw calls and resident memory. A subsystem
+// stops sweeping once a frame takes longer than the budget.
+//
+//   Stress [--max-n <n>] [--step-frames <n>] [--budget-ms <ms>] [--json <file>]
+//
+// Takes the usual render options as well, e.g. --headless or --software.
+
+namespace {
+    // Points per job for the per-frame work handed to the job system
+    const size_t JOB_GRAIN_SIZE = 4096;
+    // The path followers share this many closed curves, each through as many random points
+    const size_t PATH_COUNT = 16;
+    const size_t PATH_POINTS = 6;
+    // NDC units a follower moves along its path per frame
+    const float FOLLOWER_SPEED = 0.01f;
+
+    // Forwards to the scene canvas and counts what goes through it
+    class CountingCanvas : public Canvas
+    {
+    public:
+        explicit CountingCanvas(Canvas &target) : target(target) {}
+
+        bool loadFont(const std::string &fontPath, unsigned int pixelSize) override { return target.loadFont(fontPath, pixelSize); }
+        void clear(const glm::vec4 &color) override { target.clear(color); }
+        void drawPoints(const glm::vec3 *points, size_t count, float sizeInPixels, const glm::vec4 &color) override {
+            drawCalls++;
+            primitives += count;
+            target.drawPoints(points, count, sizeInPixels, color);
+        }
+        void drawLines(const glm::vec3 *points, size_t count, float widthInPixels, const glm::vec4 &color) override {
+            drawCalls++;
+            primitives += count / 2;
+            target.drawLines(points, count, widthInPixels, color);
+        }
+        void drawTriangles(const glm::vec3 *points, size_t count, const glm::vec4 &color) override {
+            drawCalls++;
+            primitives += count / 3;
+            target.drawTriangles(points, count, color);
+        }
+        void drawText(const std::string &text, float x, float y, float scale, const glm::vec3 &color) override {
+            drawCalls++;
+            primitives += text.size();
+            target.drawText(text, x, y, scale, color);
+        }
+        unsigned int fontPixelSize() const override { return target.fontPixelSize(); }
+        void flush() override { target.flush(); }
+        int width() const override { return target.width(); }
+        int height() const override { return target.height(); }
+
+        size_t drawCalls = 0;
+        size_t primitives = 0;
+
+    private:
+        Canvas &target;
+    };
+
+    enum Subsystem { POINTS = 1, LINES = 2, LABELS = 4, PATHS = 8, GLYPH_LABELS = 16 };
+
+    struct Step
+    {
+        std::string subsystem;
+        size_t n;
+        int frames;
+        double medianMs;
+        double maxMs;
+        size_t drawCalls;
+        size_t primitives;
+        double rssMb;
+        double peakRssMb;
+    };
+
+    struct StressScene
+    {
+        std::vector<glm::vec3> points;
+        std::vector<float> phases;
+        std::vector<std::string> labels;
+        std::vector<glm::vec2> labelPositions;
+        std::vector<glm::vec3> linePoints;
+        // Followers are grouped by path, path p owns [pathFirst[p], pathFirst[p + 1])
+        std::vector<Path> paths;
+        std::vector<size_t> pathFirst;
+        std::vector<float> followerDistances;
+        std::vector<glm::vec2> followerPositions;
+        std::vector<glm::vec3> followerPoints;
+
+        void generate(size_t n, int subsystems, JobSystem &jobs)
+        {
+            std::mt19937 random(42);
+            std::uniform_real_distribution<float> ndc(-0.95f, 0.95f);
+            std::uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+            points.resize(n);
+            phases.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                points[i] = glm::vec3(ndc(random), ndc(random), 0.0f);
+                phases[i] = phase(random);
+            }
+            labels.clear();
+            if (subsystems & (LABELS | GLYPH_LABELS)) {
+                labels.reserve(n);
+                for (const glm::vec3 &p : points)
+                    labels.push_back(glmToText(p, 1));
+            }
+            linePoints.resize(subsystems & LINES ? 2 * n : 0);
+
+            paths.clear();
+            pathFirst.clear();
+            if (subsystems & PATHS) {
+                std::vector<glm::vec2> through(PATH_POINTS);
+                paths.resize(PATH_COUNT);
+                for (Path &path : paths) {
+                    for (glm::vec2 &p : through)
+                        p = glm::vec2(ndc(random), ndc(random));
+                    path.addCatmullRom(through, true);
+                }
+                buildArcLengthTables(jobs, paths);
+                for (size_t p = 0; p <= PATH_COUNT; p++)
+                    pathFirst.push_back(n * p / PATH_COUNT);
+            }
+            size_t followers = subsystems & PATHS ? n : 0;
+            followerDistances.resize(followers);
+            followerPositions.resize(followers);
+            followerPoints.resize(followers);
+        }
+
+        // Label placement and the line animation are split across the context's
+        // job system; every draw call stays on this thread. `text` is only
+        // needed for GLYPH_LABELS.
+        void draw(CountingCanvas &canvas, TextRenderer *text, JobSystem &jobs, int subsystems, long frame)
+        {
+            const glm::vec4 orange(1.0f, 0.5f, 0.2f, 1.0f);
+            canvas.clear(glm::vec4(0.10f, 0.10f, 0.10f, 1.0f));
+
+            if (subsystems & (LABELS | GLYPH_LABELS)) {
+                // Every label in bulk, for the size the canvas has this frame
+                labelPositions.resize(labels.size());
+                CoordinateTransform toPixels = CoordinateTransform::ndcToPixels(canvas.width(), canvas.height());
+                jobs.parallelFor(0, labels.size(), JOB_GRAIN_SIZE, [&](size_t begin, size_t end) {
+                    toPixels.apply(points.data() + begin, labelPositions.data() + begin, end - begin);
+                });
+            }
+            if (subsystems & LABELS) {
+                for (size_t i = 0; i < labels.size(); i++)
+                    canvas.drawText(labels[i], labelPositions[i].x, labelPositions[i].y, 0.4f, glm::vec3(0.5f, 0.8f, 0.2f));
+            }
+            if (subsystems & GLYPH_LABELS) {
+                for (size_t i = 0; i < labels.size(); i++) {
+                    text->renderText(labels[i], labelPositions[i].x, labelPositions[i].y, 0.4f, glm::vec3(0.5f, 0.8f, 0.2f));
+                    // Not seen by the canvas; the renderer issues one draw per glyph
+                    canvas.drawCalls += labels[i].size();
+                    canvas.primitives += labels[i].size();
+                }
+            }
+            if (subsystems & POINTS)
+                canvas.drawPoints(points.data(), points.size(), 3.0f, orange);
+            if (subsystems & LINES) {
+                // Every line spins around its point
+                float angle = static_cast<float>(frame) * 0.05f;
+                jobs.parallelFor(0, points.size(), JOB_GRAIN_SIZE, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        float a = angle + phases[i];
+                        linePoints[2 * i] = points[i];
+                        linePoints[2 * i + 1] = points[i] + glm::vec3(0.04f * std::cos(a), 0.07f * std::sin(a), 0.0f);
+                    }
+                });
+                canvas.drawLines(linePoints.data(), linePoints.size(), 1.0f, orange);
+            }
+            if (subsystems & PATHS) {
+                // Every follower moves at the same speed from its own start, wrapping around its path
+                float travelled = static_cast<float>(frame) * FOLLOWER_SPEED;
+                for (size_t p = 0; p < paths.size(); p++) {
+                    size_t first = pathFirst[p];
+                    float length = paths[p].length();
+                    jobs.parallelFor(first, pathFirst[p + 1], JOB_GRAIN_SIZE, [&](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; i++)
+                            followerDistances[i] = std::fmod(phases[i] / 6.2831853f * length + travelled, length);
+                    });
+                    evaluateFollowers(paths[p], followerDistances.data() + first, followerPositions.data() + first,
+                                      pathFirst[p + 1] - first, &jobs);
+                }
+                jobs.parallelFor(0, followerPoints.size(), JOB_GRAIN_SIZE, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++)
+                        followerPoints[i] = glm::vec3(followerPositions[i], 0.0f);
+                });
+                canvas.drawPoints(followerPoints.data(), followerPoints.size(), 3.0f, glm::vec4(0.3f, 0.7f, 1.0f, 1.0f));
+            }
+        }
+    };
+}
+
+int main(int argc, char const *argv[])
+{
+    RenderContext context;
+    if (!context.create(argc, argv, "Stress", WINDOW_WIDTH, WINDOW_HEIGTH)) {
+        return -1;
+    }
+
+    size_t maxN = 1000000;
+    int stepFrames = 20;
+    int warmupFrames = 3;
+    double budgetMs = 1000.0;
+    std::string jsonPath;
+    const std::vector<std::string> &args = context.renderOptions().positional;
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] == "--max-n")
+            maxN = std::strtoull(args[++i].c_str(), nullptr, 10);
+        else if (args[i] == "--step-frames")
+            stepFrames = std::max(1, std::atoi(args[++i].c_str()));
+        else if (args[i] == "--budget-ms")
+            budgetMs = std::atof(args[++i].c_str());
+        else if (args[i] == "--json")
+            jsonPath = args[++i];
+    }
+
+    CountingCanvas canvas(context.canvas());
+    std::string font_name = std::string(RESOURCE_PATH) + "/CuteFont-Regular.ttf";
+    if (!canvas.loadFont(font_name, 48)) {
+        context.destroy();
+        return -1;
+    }
+    // The demos' per-glyph renderer, loaded the way the scene host loads it for them
+    SceneResources resources(context);
+    TextRenderer *text = nullptr;
+    if (!context.isSoftware()) {
+        text = &resources.text();
+        if (!text->isLoaded()) {
+            resources.release();
+            context.destroy();
+            return -1;
+        }
+    }
+
+    std::vector<std::pair<const char*, int>> subsystems = {
+        {"points", POINTS}, {"lines", LINES}, {"labels", LABELS}, {"paths", PATHS}
+    };
+    if (text)
+        subsystems.push_back({"glyphs", GLYPH_LABELS});
+    subsystems.push_back({"all", POINTS | LINES | LABELS | PATHS});
+
+    std::vector<Step> steps;
+    std::printf("%-8s %9s %11s %11s %11s %12s %9s %9s\n",
+                "subsystem", "N", "median ms", "max ms", "draw calls", "primitives", "RSS MB", "peak MB");
+    long frame = 0;
+    bool closed = false;
+    StressScene scene;
+
+    for (const auto &subsystem : subsystems) {
+        for (size_t n = 1; n <= maxN && !closed; n *= 10) {
+            scene.generate(n, subsystem.second, context.jobs());
+
+            std::vector<double> frameMs;
+            for (int i = 0; i < warmupFrames + stepFrames; i++) {
+                if (!context.isHeadless() && context.shouldClose()) {
+                    closed = true;
+                    break;
+                }
+                canvas.drawCalls = canvas.primitives = 0;
+                auto start = std::chrono::steady_clock::now();
+                scene.draw(canvas, text, context.jobs(), subsystem.second, frame++);
+                context.swapBuffers();
+                // Include the GPU work in the frame time
+                if (!context.isSoftware())
+                    glFinish();
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                // A single frame over budget is enough to know the answer
+                if (i >= warmupFrames || ms > budgetMs)
+                    frameMs.push_back(ms);
+                if (ms > budgetMs)
+                    break;
+            }
+            if (frameMs.empty())
+                break;
+
+            std::sort(frameMs.begin(), frameMs.end());
+            Step step;
+            step.subsystem = subsystem.first;
+            step.n = n;
+            step.frames = static_cast<int>(frameMs.size());
+            step.medianMs = frameMs[frameMs.size() / 2];
+            step.maxMs = frameMs.back();
+            step.drawCalls = canvas.drawCalls;
+            step.primitives = canvas.primitives;
+            readMemoryUsage(step.rssMb, step.peakRssMb);
+            steps.push_back(step);
+
+            std::printf("%-8s %9zu %11.3f %11.3f %11zu %12zu %9.1f %9.1f\n", step.subsystem.c_str(), step.n,
+                        step.medianMs, step.maxMs, step.drawCalls, step.primitives, step.rssMb, step.peakRssMb);
+            std::fflush(stdout);
+
+            if (step.medianMs > budgetMs) {
+                std::printf("%-8s stops here: %.1f ms per frame is over the %.0f ms budget\n",
+                            step.subsystem.c_str(), step.medianMs, budgetMs);
+                break;
+            }
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        out << "{\n  \"backend\": \"" << (context.isSoftware() ? "software" : "gl") << "\",\n  \"steps\": [";
+        for (size_t i = 0; i < steps.size(); i++) {
+            const Step &s = steps[i];
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"subsystem\": \"" << s.subsystem << "\", \"n\": " << s.n << ", \"frames\": " << s.frames
+                << ", \"median_ms\": " << s.medianMs << ", \"max_ms\": " << s.maxMs
+                << ", \"draw_calls\": " << s.drawCalls << ", \"primitives\": " << s.primitives
+                << ", \"rss_mb\": " << s.rssMb << ", \"peak_rss_mb\": " << s.peakRssMb << "}";
+        }
+        out << "\n  ]\n}\n";
+        if (!out)
+            std::cout << "ERROR::STRESS: Failed to write " << jsonPath << std::endl;
+    }
+
+    resources.release();
+    context.destroy();
+    return context.overAllocationBudget() ? EXIT_FAILURE : 0;
+}
@@ -8,326 +8,204 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm/ext.hpp>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include <filesystem>
-#include <map>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 
-#include "GlfwWindowUtils.h"
-#include "textRenderer.h"
+#include "Canvas.h"
+#include "CoordinateTransform.h"
+#include "FileWatcher.h"
+#include "JobSystem.h"
+#include "LayerCache.h"
+#include "SceneFormat.h"
+#include "scene.h"
 #include "utils.h"
 
-#define WINDOW_WIDTH 1920.0
-#define WINDOW_HEIGTH 1080.0
-
-TextRenderer textRenderer;
-std::map<GLchar, Character> Characters;
-GLuint textVAO, textVBO;
-
-float mapValue(float x, float inMin, float inMax, float outMin, float outMax) {
-    float t = (x - inMin) / (inMax - inMin);           // normalize to [0, 1]
-    return glm::mix(outMin, outMax, t);                // map to [outMin, outMax]
-}
-
-int main(int argc, char const *argv[])
-{
-    glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_SAMPLES, 8);
-
-    GLFWwindow *window = glfwCreateWindow(1920, 1080, "Triangle Points", NULL, NULL);
-	if(window == NULL){
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-    
-    glfwMakeContextCurrent(window);
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)){
-		std::cout << "Failed to initialize GLAD" << std::endl;
-		return -1;
-	}
+namespace {
+    // How long the finished picture stays up before a playlist moves on
+    const float FINISHED_HOLD = 2.0f;
+    // Tracks evaluated per job; scenes with fewer run on the calling thread
+    const size_t TRACK_GRAIN_SIZE = 64;
 
-    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGTH);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glEnable(GL_MULTISAMPLE);
-    
-    const char* vertexShaderSource = R"(
-        #version 330 core
-        layout (location = 0) in vec3 aPos;
-        void main() {
-            gl_Position = vec4(aPos, 1.0);
-            gl_PointSize = 15.0f; // Size in pixels
-        }
-    )";
-
-    const char* fragmentShaderSource = R"(
-        #version 330 core
-        out vec4 FragColor;
-        void main() {
-            FragColor = vec4(1.0, 0.5, 0.2, 1.0); // orange
+    // Edges drawn one by one and filled, as described by a scene file
+    class TriangleLinesScene : public Scene
+    {
+    public:
+        bool setup(SceneResources &resources, const std::vector<std::string> &arguments) override;
+        double duration() const override { return sceneEndTime(scene) + FINISHED_HOLD; }
+        bool isUnchanged(double time) override;
+        void render(SceneResources &resources, double time) override;
+        void release() override;
+        bool needsGl() const override { return false; }
+
+    private:
+        // Copies the label strings out of the scene file and sizes the per-frame
+        // buffers for the most the scene can draw, once per load
+        void prepareBuffers();
+
+        Canvas *canvas = nullptr;
+        std::string scenePath;
+        SceneFile scene;
+        FileWatcher sceneWatcher;
+        bool reloaded = false;
+
+        // Labels, points and every edge that has finished drawing only change when
+        // another track finishes or the scene is reloaded, so they are cached
+        enum { STATIC_LAYER, LAYER_COUNT };
+        LayerCache layers;
+        uint32_t finishedTracks = 0;
+
+        // Refilled every frame; kept so their storage is reused. Every track is
+        // evaluated into its own list so they can be evaluated in parallel.
+        std::vector<std::vector<glm::vec3>> trackLinePoints;
+        std::vector<uint8_t> trackFinished;
+        std::vector<glm::vec3> drawPoints, staticLinePoints, linePoints, fillPoints;
+        std::vector<glm::vec2> labelPositions;
+        std::vector<std::string> labelTexts;
+
+        unsigned int pointCounts = 0;
+        bool isAnimationFinished = false;
+    };
+
+    bool TriangleLinesScene::setup(SceneResources &resources, const std::vector<std::string> &arguments)
+    {
+        // Points, lines, fills and labels all go through the canvas so the scene
+        // renders the same with GL or with the software rasterizer (--software).
+        canvas = &resources.canvas();
+
+        // Load the scene description
+        // Points, labels and timings come from the scene file and are reloaded
+        // whenever the file changes on disk.
+        scenePath = !arguments.empty() ? arguments[0] : std::string(SCENE_PATH) + "/triangleLines.scene";
+        if (!loadScene(scenePath, scene)) {
+            std::cout << "ERROR::SCENE: Failed to load " << scenePath << std::endl;
+            return false;
         }
-    )";
-    
-    // 1. Compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
+        sceneWatcher.watch(scenePath);
+        prepareBuffers();
 
-    // 2. Compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-
-    // 3. Link shaders into program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // FreeType
-    // --------
-    FT_Library ft;
-    // All functions return a value different than 0 whenever an error occurred
-    if (FT_Init_FreeType(&ft))
-    {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return -1;
+        return layers.setup(resources.context, LAYER_COUNT);
     }
 
-	// find path to font
-    std::string font_name = std::string(RESOURCE_PATH) + "/CuteFont-Regular.ttf";
-    if (font_name.empty())
+    bool TriangleLinesScene::isUnchanged(double time)
     {
-        std::cout << "ERROR::FREETYPE: Failed to load font_name" << std::endl;
-        return -1;
-    }
-	
-	// load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, font_name.c_str(), 0, &face)) {
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        return -1;
-    }
-    else {
-        // set size to load glyphs as
-        FT_Set_Pixel_Sizes(face, 0, 48);
-
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-        // load first 128 characters of ASCII set
-        for (unsigned char c = 0; c < 128; c++)
-        {
-            // Load character glyph 
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-            {
-                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-                continue;
-            }
-            // generate texture
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-            // set texture options
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            // now store character for later use
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                static_cast<unsigned int>(face->glyph->advance.x)
-            };
-            Characters.insert(std::pair<char, Character>(c, character));
+        reloaded = !sceneWatcher.poll().empty() && loadScene(scenePath, scene);
+        if (reloaded) {
+            std::cout << "Reloaded " << scenePath << std::endl;
+            prepareBuffers();
         }
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-
-
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    // 4. Set up vertex data
-    // For points
-    glm::vec3 top = glm::vec3(0.0f, 0.5f, 0.0f);
-    glm::vec3 bottomLeft = glm::vec3(-0.5f, -0.5f, 0.0f);
-    glm::vec3 bottomRight = glm::vec3(0.5f, -0.5f, 0.0f);
-
-    // Text of Points
-    glm::vec3 topTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
-    std::string topText, bottomLeftText, bottomRightText;
-    unsigned int precisionVal = 1;
-
-    topTextCoords.x = mapValue(-0.075f, -1.0f, 1.0f, 0.0f, 1920.0f);
-    topTextCoords.y = mapValue(0.59f, -1.0f, 1.0f, 0.0f, 1080.0f);
-    topText = glmToText(top, precisionVal);
-
-    glm::vec3 bottomLeftTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
-    bottomLeftTextCoords.x = mapValue(-0.6, -1.0f, 1.0f, 0.0f, 1920.0f);
-    bottomLeftTextCoords.y = mapValue(-0.59f, -1.0f, 1.0f, 0.0f, 1080.0f);
-    bottomLeftText = glmToText(bottomLeft, precisionVal);
-
-    glm::vec3 bottomRightTextCoords = glm::vec3(0.0f, 0.0f, 0.0f);
-    bottomRightTextCoords.x = mapValue(0.415f, -1.0f, 1.0f, 0.0f, 1920.0f);
-    bottomRightTextCoords.y = mapValue(-0.59f, -1.0f, 1.0f, 0.0f, 1080.0f);
-    bottomRightText = glmToText(bottomRight, precisionVal);
-
-    float startTime = glfwGetTime();
-    unsigned int pointCounts = 0;
-    bool isAnimationFinished = false;
 
-	while(!glfwWindowShouldClose(window)){
-
-        glClearColor(0.10, 0.10, 0.10, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);    
-
-        float currentTime = glfwGetTime();
-        float totalAnimDuration = 10.0f;
-        float elapsed = currentTime - startTime;
-        float segmentDuration = 3.0f;
-
-        std::vector<glm::vec3> drawPoints, linePoints, trianglePoints;
-        std::string text = "";
-        std::string topTextString = "";
-        std::string bottomRightTextString = "";
-
-        drawPoints.push_back(bottomLeft);
-        drawPoints.push_back(top);
-        drawPoints.push_back(bottomRight);
-        pointCounts = 3;
-
-        textRenderer.renderText(Characters, textVAO, textVBO, bottomLeftText, bottomLeftTextCoords.x, bottomLeftTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        textRenderer.renderText(Characters, textVAO, textVBO, topText, topTextCoords.x, topTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        textRenderer.renderText(Characters, textVAO, textVBO, bottomRightText, bottomRightTextCoords.x, bottomRightTextCoords.y, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-
-
-        float totalTime = 3.0f; // 3 seconds
-        float pauseDuration = 3.0f;
-        float time = glm::clamp(elapsed, 0.0f, segmentDuration);
-        
-        if (elapsed < segmentDuration) {
-            float localT = time / segmentDuration;
-            glm::vec3 current = bottomLeft + localT * (top - bottomLeft);
-            linePoints.push_back(bottomLeft);
-            linePoints.push_back(current);
-        } 
-        else if (elapsed < 2 * segmentDuration) {       
-            linePoints.push_back(bottomLeft);
-            linePoints.push_back(top);
-            linePoints.push_back(top);
-            float localT = (elapsed - segmentDuration) / (segmentDuration);
-            glm::vec3 current = top + localT * (bottomRight - top);
-            if (localT == 1) current = bottomRight;
-            linePoints.push_back(current);
-        } 
-        else if (elapsed < (3 * segmentDuration) + pauseDuration){
-            linePoints.push_back(bottomLeft);
-            linePoints.push_back(top);
-            linePoints.push_back(top);
-            linePoints.push_back(bottomRight);
+        // Once every track has finished the picture stays the same until the scene
+        // changes; the time check covers a playlist starting the scene over
+        return isAnimationFinished && time >= sceneEndTime(scene) && !reloaded;
+    }
 
-            linePoints.push_back(bottomRight);
-            float localT = (elapsed - 2 * segmentDuration) / (segmentDuration);
-            glm::vec3 current = bottomRight + localT * (bottomLeft - bottomRight);
-            if (localT >= 1.0f){
-                current = bottomLeft;
-                
-            } 
-            linePoints.push_back(current);
+    void TriangleLinesScene::render(SceneResources &resources, double time)
+    {
+        canvas->clear(glm::vec4(0.10f, 0.10f, 0.10f, 1.0f));
 
-        } else {
-            linePoints.push_back(bottomLeft);
-            linePoints.push_back(top);
+        float elapsed = time;
 
-            linePoints.push_back(top);
-            linePoints.push_back(bottomRight);
+        drawPoints.clear();
+        staticLinePoints.clear();
+        linePoints.clear();
+        fillPoints.clear();
+        labelPositions.clear();
 
-            linePoints.push_back(bottomRight);
-            linePoints.push_back(bottomLeft);
-            isAnimationFinished = true;
+        resources.context.jobs().parallelFor(0, scene.trackCount(), TRACK_GRAIN_SIZE, [this, elapsed](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                trackLinePoints[i].clear();
+                trackFinished[i] = evaluateTrack(scene, scene.tracks()[i], elapsed, trackLinePoints[i]);
+            }
+        });
+
+        uint32_t finishedCount = 0;
+        for (uint32_t i = 0; i < scene.trackCount(); i++) {
+            const SceneTrack &track = scene.tracks()[i];
+            const std::vector<glm::vec3> &points = trackLinePoints[i];
+            if (trackFinished[i]) {
+                finishedCount++;
+                staticLinePoints.insert(staticLinePoints.end(), points.begin(), points.end());
+                if (track.fill)
+                    polylineFill(scene, track.polyline, fillPoints);
+            } else {
+                // Still moving, its edges are drawn every frame
+                linePoints.insert(linePoints.end(), points.begin(), points.end());
+            }
+        }
+        isAnimationFinished = finishedCount == scene.trackCount();
+        if (reloaded || finishedCount != finishedTracks) {
+            layers.invalidate(STATIC_LAYER);
+            finishedTracks = finishedCount;
         }
-        
-        GLuint VAO, VBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // Wrong one
-        // glBufferData(GL_ARRAY_BUFFER, sizeof(drawPoints), &drawPoints[0], GL_STATIC_DRAW);
-        glBufferData(GL_ARRAY_BUFFER, drawPoints.size() * sizeof(glm::vec3), drawPoints.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        if (isAnimationFinished){
-            glDrawArrays(GL_TRIANGLES, 0, pointCounts);
-        }  
-        glEnable(GL_PROGRAM_POINT_SIZE);  // This is important!
-        glDrawArrays(GL_POINTS, 0, pointCounts);
 
-        GLuint triangleLineVAO, triangleLineVBO;
-        glGenVertexArrays(1, &triangleLineVAO);
-        glGenBuffers(1, &triangleLineVAO);
+        const glm::vec4 orange(1.0f, 0.5f, 0.2f, 1.0f);
+        if (layers.begin(STATIC_LAYER)) {
+            for (uint32_t i = 0; i < scene.pointCount(); i++)
+                drawPoints.push_back(scene.point(i));
+            pointCounts = drawPoints.size();
 
-        glBindVertexArray(triangleLineVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, triangleLineVBO);
-        // Wrong one
-        // glBufferData(GL_ARRAY_BUFFER, sizeof(drawPoints), &drawPoints[0], GL_STATIC_DRAW);
-        glBufferData(GL_ARRAY_BUFFER, linePoints.size() * sizeof(glm::vec3), linePoints.data(), GL_STATIC_DRAW);
+            for (uint32_t i = 0; i < scene.labelCount(); i++) {
+                const SceneLabel &label = scene.labels()[i];
+                glm::vec3 anchor = scene.point(label.point);
+                labelPositions.push_back(glm::vec2(anchor.x + label.offsetX, anchor.y + label.offsetY));
+            }
+            CoordinateTransform::ndcToPixels(canvas->width(), canvas->height())
+                .apply(labelPositions.data(), labelPositions.data(), labelPositions.size());
+            for (uint32_t i = 0; i < scene.labelCount(); i++) {
+                const SceneLabel &label = scene.labels()[i];
+                canvas->drawText(labelTexts[i], labelPositions[i].x, labelPositions[i].y, label.scale,
+                                 glm::vec3(label.color[0], label.color[1], label.color[2]));
+            }
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+            if (isAnimationFinished) {
+                canvas->drawTriangles(fillPoints.data(), fillPoints.size(), orange);
+            }
+            canvas->drawPoints(drawPoints.data(), pointCounts, 15.0f, orange);
+            canvas->drawLines(staticLinePoints.data(), staticLinePoints.size(), 1.0f, orange);
+            layers.end();
+        }
+        layers.composite(STATIC_LAYER);
+        canvas->drawLines(linePoints.data(), linePoints.size(), 1.0f, orange);
+    }
 
-        // 5. Draw
-        glBindVertexArray(triangleLineVAO);
-        glDrawArrays(GL_LINES, 0, 6);
+    void TriangleLinesScene::prepareBuffers()
+    {
+        labelTexts.clear();
+        for (uint32_t i = 0; i < scene.labelCount(); i++)
+            labelTexts.push_back(scene.labelText(scene.labels()[i]));
+
+        trackLinePoints.resize(scene.trackCount());
+        trackFinished.resize(scene.trackCount());
+        size_t lineCount = 0, fillCount = 0;
+        for (uint32_t i = 0; i < scene.trackCount(); i++) {
+            const SceneTrack &track = scene.tracks()[i];
+            const ScenePolyline &polyline = scene.polylines()[track.polyline];
+            size_t trackLineCount = 2 * (polyline.closed ? polyline.indexCount : polyline.indexCount - 1);
+            trackLinePoints[i].reserve(trackLineCount);
+            lineCount += trackLineCount;
+            if (track.fill)
+                fillCount += 3 * (polyline.indexCount - 2);
+        }
+        drawPoints.reserve(scene.pointCount());
+        staticLinePoints.reserve(lineCount);
+        linePoints.reserve(lineCount);
+        fillPoints.reserve(fillCount);
+        labelPositions.reserve(scene.labelCount());
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    void TriangleLinesScene::release()
+    {
+        layers.release();
     }
+}
+
+std::unique_ptr<Scene> createTriangleLinesScene()
+{
+    return std::make_unique<TriangleLinesScene>();
+}
 
-    glDeleteVertexArrays(1, &textVAO);
-    glDeleteBuffers(1, &textVBO);
-    glDeleteProgram(shaderProgram); 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    glfwTerminate();
-    return 0;
-}
\ No newline at end of file
+SCENE_PLUGIN_ENTRY(createTriangleLinesScene)
@@ -0,0 +1,126 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	// A sample shorter than this is mostly clock overhead
+	const double MIN_SAMPLE_NS = 100000.0;
+	// Slow benchmarks take fewer samples so a full run stays short
+	const double SAMPLE_BUDGET_NS = 1.0e9;
+	const int MIN_REPETITIONS = 5;
+
+	double timeSample(const std::function<void()> &body, long iterations)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (long i = 0; i < iterations; i++)
+			body();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count();
+	}
+}
+
+BenchmarkOptions parseBenchmarkOptions(int argc, char const *argv[])
+{
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--filter" && hasValue)
+			options.filter = argv[++i];
+		else if (arg == "--reps" && hasValue)
+			options.repetitions = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--warmup" && hasValue)
+			options.warmup = std::max(0, std::atoi(argv[++i]));
+		else if (arg == "--max-size" && hasValue)
+			options.maxSize = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+		else if (arg == "--json" && hasValue)
+			options.jsonPath = argv[++i];
+		else
+			std::cout << "ERROR::BENCH: Unknown argument " << arg << std::endl;
+	}
+	return options;
+}
+
+std::vector<size_t> BenchmarkRunner::sizes() const
+{
+	std::vector<size_t> result;
+	for (size_t size = 1; size <= options.maxSize; size *= 16)
+		result.push_back(size);
+	if (result.back() != options.maxSize)
+		result.push_back(options.maxSize);
+	return result;
+}
+
+void BenchmarkRunner::run(const std::string &name, size_t elements, const std::function<void()> &body)
+{
+	if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+		return;
+
+	if (benchmarkResults.empty())
+		std::printf("%-28s %9s %6s %13s %13s %11s\n", "benchmark", "elements", "reps", "median ns", "p99 ns", "ns/element");
+
+	// Calibrate the calls per sample, this doubles as the first warmup
+	long iterations = 1;
+	double sampleNs = timeSample(body, iterations);
+	while (sampleNs < MIN_SAMPLE_NS && iterations < (1L << 30))
+	{
+		iterations *= 2;
+		sampleNs = timeSample(body, iterations);
+	}
+	for (int i = 1; i < options.warmup; i++)
+		timeSample(body, iterations);
+
+	int repetitions = static_cast<int>(std::min<double>(options.repetitions, SAMPLE_BUDGET_NS / sampleNs));
+	repetitions = std::max(repetitions, std::min(MIN_REPETITIONS, options.repetitions));
+
+	std::vector<double> samples(repetitions);
+	for (double &sample : samples)
+		sample = timeSample(body, iterations) / iterations;
+	std::sort(samples.begin(), samples.end());
+
+	BenchmarkResult result;
+	result.name = name;
+	result.elements = elements;
+	result.repetitions = repetitions;
+	result.iterations = iterations;
+	result.medianNs = samples[samples.size() / 2];
+	result.p99Ns = samples[static_cast<size_t>(std::ceil(0.99 * samples.size())) - 1];
+	result.nsPerElement = result.medianNs / elements;
+	benchmarkResults.push_back(result);
+
+	std::printf("%-28s %9zu %6d %13.1f %13.1f %11.3f\n", name.c_str(), elements, repetitions,
+	            result.medianNs, result.p99Ns, result.nsPerElement);
+	std::fflush(stdout);
+}
+
+bool BenchmarkRunner::writeJson() const
+{
+	if (options.jsonPath.empty())
+		return true;
+
+	std::ofstream out(options.jsonPath);
+	if (!out)
+	{
+		std::cout << "ERROR::BENCH: Failed to open " << options.jsonPath << std::endl;
+		return false;
+	}
+	out << "{\n  \"benchmarks\": [";
+	for (size_t i = 0; i < benchmarkResults.size(); i++)
+	{
+		const BenchmarkResult &r = benchmarkResults[i];
+		out << (i == 0 ? "\n" : ",\n")
+		    << "    {\"name\": \"" << r.name << "\", \"elements\": " << r.elements
+		    << ", \"repetitions\": " << r.repetitions << ", \"iterations\": " << r.iterations
+		    << ", \"median_ns\": " << r.medianNs << ", \"p99_ns\": " << r.p99Ns
+		    << ", \"ns_per_element\": " << r.nsPerElement << "}";
+	}
+	out << "\n  ]\n}\n";
+	return static_cast<bool>(out);
+}
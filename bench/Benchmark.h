@@ -0,0 +1,66 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Command line of a benchmark executable:
+//
+//   --filter <text>   only run benchmarks whose name contains <text>
+//   --reps <n>        timed samples per benchmark (default 31, fewer for slow ones)
+//   --warmup <n>      untimed samples before the timed ones (default 3)
+//   --max-size <n>    largest input size (default 1048576)
+//   --json <file>     also write the results as JSON
+struct BenchmarkOptions
+{
+	std::string filter;
+	int repetitions = 31;
+	int warmup = 3;
+	size_t maxSize = size_t(1) << 20;
+	std::string jsonPath;
+};
+
+BenchmarkOptions parseBenchmarkOptions(int argc, char const *argv[]);
+
+struct BenchmarkResult
+{
+	std::string name;
+	size_t elements;
+	int repetitions;
+	long iterations; // body calls per sample
+	double medianNs;
+	double p99Ns;
+	double nsPerElement;
+};
+
+// Times a body that processes `elements` inputs per call. The warmup also
+// calibrates how many calls make up one sample so that even single-element
+// runs are long enough for the clock; every sample is then divided back down
+// to one call. Reported times are per call.
+class BenchmarkRunner
+{
+public:
+	explicit BenchmarkRunner(const BenchmarkOptions &options) : options(options) {}
+
+	void run(const std::string &name, size_t elements, const std::function<void()> &body);
+	// Input sizes 1, 16, 256, ... up to the --max-size option.
+	std::vector<size_t> sizes() const;
+
+	bool writeJson() const;
+	const std::vector<BenchmarkResult> &results() const { return benchmarkResults; }
+
+private:
+	BenchmarkOptions options;
+	std::vector<BenchmarkResult> benchmarkResults;
+};
+
+// Keeps the compiler from discarding a result that is never used.
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif
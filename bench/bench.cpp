@@ -0,0 +1,128 @@
+#include <glm/glm/glm.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CoordinateTransform.h"
+#include "Path.h"
+#include "utils.h"
+
+// CPU-only throughput benchmarks for the helpers in misc/, the coordinate
+// transforms the scenes place labels with and the path lookup Stress moves
+// its followers with. Every benchmark
+// runs over all input sizes; inputs are generated up front from a fixed seed
+// so runs are comparable. Example:
+//
+//   bench --filter glmToText --json glmToText.json
+int main(int argc, char const *argv[])
+{
+    BenchmarkOptions options = parseBenchmarkOptions(argc, argv);
+    BenchmarkRunner runner(options);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> ndc(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> degrees(0.0f, 360.0f);
+
+    // One closed curve through 16 points, the lookups below land anywhere on it
+    std::vector<glm::vec2> pathPoints(16);
+    for (glm::vec2 &p : pathPoints)
+        p = glm::vec2(ndc(random), ndc(random));
+    Path path;
+    path.addCatmullRom(pathPoints, true);
+    path.buildArcLengthTable();
+
+    for (size_t n : runner.sizes()) {
+        std::vector<float> angles(n), results(n);
+        std::vector<glm::vec2> firstPoints(n), secondPoints(n), points(n);
+        std::vector<glm::vec3> starts(n), ends(n);
+        for (size_t i = 0; i < n; i++) {
+            angles[i] = degrees(random);
+            firstPoints[i] = glm::vec2(ndc(random), ndc(random));
+            secondPoints[i] = glm::vec2(ndc(random), ndc(random));
+            starts[i] = glm::vec3(firstPoints[i], 0.0f);
+            ends[i] = glm::vec3(secondPoints[i], 0.0f);
+        }
+        std::vector<float> distances(n);
+        for (size_t i = 0; i < n; i++)
+            distances[i] = angles[i] / 360.0f * path.length();
+
+        // One point at a time against the bulk kernels, NDC to 1080p pixels
+        const CoordinateTransform toPixels = CoordinateTransform::ndcToPixels(1920, 1080);
+        std::vector<glm::vec2> pixels(n);
+        runner.run("ndcToPixels", n, [&]() {
+            for (size_t i = 0; i < n; i++)
+                pixels[i] = toPixels.apply(firstPoints[i]);
+            doNotOptimize(pixels.data());
+        });
+
+        runner.run("ndcToPixelsBulk", n, [&]() {
+            toPixels.apply(firstPoints.data(), pixels.data(), n);
+            doNotOptimize(pixels.data());
+        });
+
+        runner.run("ndcToPixelsBulkVec3", n, [&]() {
+            toPixels.apply(starts.data(), pixels.data(), n);
+            doNotOptimize(pixels.data());
+        });
+
+        // Binary search into the arc-length table plus one Bézier evaluation per point
+        runner.run("pathPointAtDistance", n, [&]() {
+            for (size_t i = 0; i < n; i++)
+                points[i] = path.pointAtDistance(distances[i]);
+            doNotOptimize(points.data());
+        });
+
+        runner.run("pathFollowersBulk", n, [&]() {
+            evaluateFollowers(path, distances.data(), points.data(), n);
+            doNotOptimize(points.data());
+        });
+
+        runner.run("degreeToRad", n, [&]() {
+            for (size_t i = 0; i < n; i++)
+                results[i] = degreeToRad(angles[i]);
+            doNotOptimize(results.data());
+        });
+
+        runner.run("polartToCartesien", n, [&]() {
+            for (size_t i = 0; i < n; i++) {
+                Point p = polartToCartesien(0.0f, 0.0f, 0.5f, angles[i]);
+                points[i] = glm::vec2(p.x, p.y);
+            }
+            doNotOptimize(points.data());
+        });
+
+        runner.run("polarCartesien", n, [&]() {
+            for (size_t i = 0; i < n; i++)
+                points[i] = polarCartesien(firstPoints[i], angles[i], 0.5f);
+            doNotOptimize(points.data());
+        });
+
+        runner.run("findMiddlePoint", n, [&]() {
+            for (size_t i = 0; i < n; i++)
+                points[i] = findMiddlePoint(firstPoints[i], secondPoints[i]);
+            doNotOptimize(points.data());
+        });
+
+        std::vector<std::string> texts(n);
+        runner.run("glmToText", n, [&]() {
+            for (size_t i = 0; i < n; i++)
+                texts[i] = glmToText(starts[i], 1);
+            doNotOptimize(texts.data());
+        });
+
+        // 6 vertices of 5 floats per line; the containers keep their capacity between calls
+        std::vector<float> quadVertices;
+        std::vector<glm::vec2> midPoints;
+        runner.run("createLineWithQuads", n, [&]() {
+            quadVertices.clear();
+            midPoints.clear();
+            for (size_t i = 0; i < n; i++)
+                createLineWithQuads(starts[i], ends[i], 0.01f, quadVertices, midPoints);
+            doNotOptimize(quadVertices.data());
+        });
+    }
+
+    return runner.writeJson() ? 0 : 1;
+}
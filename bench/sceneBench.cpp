@@ -0,0 +1,402 @@
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs every scene headless for a fixed number of frames on the deterministic
+// clock, each in its own process with --frame-stats, and summarizes the
+// per-frame CPU and GPU times as percentiles together with the startup time,
+// peak RSS and GL object counts. Only needs Mesa's software GL (llvmpipe).
+//
+//   SceneBench [--frames <n>] [--fps <f>] [--warmup <n>] [--scenes <a,b>]
+//              [--software] [--out <dir>] [--json <file>]
+//              [--baseline <file>] [--tolerance <percent>]
+//
+// --software runs the scenes that draw through the canvas only, on the CPU
+// rasterizer; the ones that need GL are skipped.
+//
+// --json writes the report, one scene per line. Given a report from an
+// earlier build as --baseline, every metric that got worse by more than the
+// tolerance (default 10%) is flagged and the exit code is 1, as it is when a
+// scene fails to run.
+
+namespace {
+	struct Scene
+	{
+		const char *name;
+		const char *path;
+		std::vector<std::string> args;
+		// Draws through the canvas only, so it also runs under --software
+		bool software;
+	};
+
+	struct Options
+	{
+		long frames = 300;
+		double fps = 60.0;
+		long warmup = 10;
+		bool software = false;
+		double tolerance = 10.0;
+		std::string scenes;
+		std::string outDir;
+		std::string jsonPath;
+		std::string baselinePath;
+	};
+
+	// Field names of the report, in order; the comparison goes over all but
+	// the counts at the start.
+	const char *const METRICS[] = {
+		"frames", "startup_ms", "wall_ms", "peak_rss_mb", "gl_objects_created", "gl_objects_live", "draw_calls",
+		"frame_p50_ms", "frame_p95_ms", "frame_p99_ms",
+		"cpu_p50_ms", "cpu_p95_ms", "cpu_p99_ms",
+		"gpu_p50_ms", "gpu_p95_ms", "gpu_p99_ms"
+	};
+	const int METRIC_COUNT = sizeof(METRICS) / sizeof(METRICS[0]);
+	const int FIRST_COMPARED = 1;
+	// Differences below these are noise whatever the percentage says
+	const double MIN_MS_CHANGE = 0.1;
+	const double MIN_MB_CHANGE = 2.0;
+
+	struct Result
+	{
+		std::string scene;
+		bool ok = false;
+		// Indexed like METRICS, negative when the run did not measure it
+		double values[METRIC_COUNT];
+	};
+
+	Options parseOptions(int argc, char const *argv[])
+	{
+		Options options;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--frames" && hasValue)
+				options.frames = std::max(1L, std::atol(argv[++i]));
+			else if (arg == "--fps" && hasValue)
+				options.fps = std::atof(argv[++i]);
+			else if (arg == "--warmup" && hasValue)
+				options.warmup = std::max(0L, std::atol(argv[++i]));
+			else if (arg == "--scenes" && hasValue)
+				options.scenes = argv[++i];
+			else if (arg == "--software")
+				options.software = true;
+			else if (arg == "--out" && hasValue)
+				options.outDir = argv[++i];
+			else if (arg == "--json" && hasValue)
+				options.jsonPath = argv[++i];
+			else if (arg == "--baseline" && hasValue)
+				options.baselinePath = argv[++i];
+			else if (arg == "--tolerance" && hasValue)
+				options.tolerance = std::atof(argv[++i]);
+			else
+				std::cout << "ERROR::BENCH: Unknown argument " << arg << std::endl;
+		}
+		return options;
+	}
+
+	bool selected(const Options &options, const std::string &name)
+	{
+		if (options.scenes.empty())
+			return true;
+		std::stringstream list(options.scenes);
+		std::string entry;
+		while (std::getline(list, entry, ','))
+			if (entry == name)
+				return true;
+		return false;
+	}
+
+	int metricIndex(const char *name)
+	{
+		for (int i = 0; i < METRIC_COUNT; i++)
+			if (std::strcmp(METRICS[i], name) == 0)
+				return i;
+		return -1;
+	}
+
+	// The files read here are written by FrameStats and by this runner, so a
+	// key lookup is all the JSON parsing they need.
+	bool findNumber(const std::string &text, const std::string &key, double &value)
+	{
+		size_t at = text.find("\"" + key + "\":");
+		if (at == std::string::npos)
+			return false;
+		value = std::strtod(text.c_str() + at + key.size() + 3, nullptr);
+		return true;
+	}
+
+	std::vector<double> findArray(const std::string &text, const std::string &key)
+	{
+		std::vector<double> values;
+		size_t at = text.find("\"" + key + "\":");
+		if (at == std::string::npos)
+			return values;
+		const char *p = std::strchr(text.c_str() + at, '[');
+		while (p && *p != ']')
+		{
+			char *end;
+			double value = std::strtod(p + 1, &end);
+			if (end == p + 1)
+				break;
+			values.push_back(value);
+			p = end;
+		}
+		return values;
+	}
+
+	std::string readFile(const std::string &path)
+	{
+		std::ifstream in(path);
+		std::stringstream text;
+		text << in.rdbuf();
+		return text.str();
+	}
+
+	// Nearest rank on the frames after the warmup; negative samples were never measured
+	double percentile(std::vector<double> values, long warmup, double p)
+	{
+		values.erase(values.begin(), values.begin() + std::min<size_t>(warmup, values.size()));
+		values.erase(std::remove_if(values.begin(), values.end(), [](double v) { return v < 0.0; }), values.end());
+		if (values.empty())
+			return -1.0;
+		std::sort(values.begin(), values.end());
+		size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+		return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+	}
+
+	// Columns that were never measured (no GL in software runs) show as "-"
+	std::string formatMetric(double value, int precision)
+	{
+		if (value < 0.0)
+			return "-";
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.*f", precision, value);
+		return text;
+	}
+
+	// Runs the scene with its output going to a log next to its stats
+	bool runScene(const Scene &scene, const Options &options, const std::string &statsPath, const std::string &logPath, double &wallMs)
+	{
+		std::vector<std::string> args = {scene.path, "--headless", "--frames", std::to_string(options.frames),
+			"--fps", std::to_string(options.fps), "--frame-stats", statsPath};
+		if (options.software)
+			args.push_back("--software");
+		args.insert(args.end(), scene.args.begin(), scene.args.end());
+
+		auto start = std::chrono::steady_clock::now();
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			int log = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (log >= 0)
+			{
+				dup2(log, STDOUT_FILENO);
+				dup2(log, STDERR_FILENO);
+				close(log);
+			}
+			std::vector<char*> childArgv;
+			for (std::string &arg : args)
+				childArgv.push_back(&arg[0]);
+			childArgv.push_back(nullptr);
+			execv(scene.path, childArgv.data());
+			std::printf("ERROR::BENCH: Failed to start %s\n", scene.path);
+			_exit(127);
+		}
+		if (pid < 0)
+		{
+			std::cout << "ERROR::BENCH: fork failed for " << scene.name << std::endl;
+			return false;
+		}
+		int status = 0;
+		waitpid(pid, &status, 0);
+		wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+
+	Result summarize(const std::string &name, const std::string &statsPath, double wallMs, long warmup)
+	{
+		Result result;
+		result.scene = name;
+		std::fill(result.values, result.values + METRIC_COUNT, -1.0);
+		std::string text = readFile(statsPath);
+		if (text.empty())
+			return result;
+		result.ok = true;
+
+		double *v = result.values;
+		findNumber(text, "frames", v[metricIndex("frames")]);
+		findNumber(text, "startup_ms", v[metricIndex("startup_ms")]);
+		findNumber(text, "peak_rss_mb", v[metricIndex("peak_rss_mb")]);
+		v[metricIndex("wall_ms")] = wallMs;
+
+		double created, deleted, drawCalls;
+		if (findNumber(text, "gl_objects_created", created) && findNumber(text, "gl_objects_deleted", deleted))
+		{
+			v[metricIndex("gl_objects_created")] = created;
+			v[metricIndex("gl_objects_live")] = created - deleted;
+		}
+		if (findNumber(text, "gl_draw_calls", drawCalls) && v[metricIndex("frames")] > 0)
+			v[metricIndex("draw_calls")] = drawCalls / v[metricIndex("frames")];
+
+		const char *series[] = {"frame", "cpu", "gpu"};
+		for (const char *s : series)
+		{
+			std::vector<double> values = findArray(text, std::string(s) + "_ms");
+			v[metricIndex((std::string(s) + "_p50_ms").c_str())] = percentile(values, warmup, 50.0);
+			v[metricIndex((std::string(s) + "_p95_ms").c_str())] = percentile(values, warmup, 95.0);
+			v[metricIndex((std::string(s) + "_p99_ms").c_str())] = percentile(values, warmup, 99.0);
+		}
+		return result;
+	}
+
+	bool writeReport(const std::string &path, const std::vector<Result> &results)
+	{
+		std::ofstream out(path);
+		out << "{\"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result &r = results[i];
+			out << "{\"scene\": \"" << r.scene << "\", \"ok\": " << (r.ok ? "true" : "false");
+			for (int m = 0; m < METRIC_COUNT; m++)
+				if (r.values[m] >= 0.0)
+					out << ", \"" << METRICS[m] << "\": " << r.values[m];
+			out << (i + 1 < results.size() ? "},\n" : "}\n");
+		}
+		out << "]}\n";
+		if (!out)
+		{
+			std::cout << "ERROR::BENCH: Failed to write " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Returns the number of regressions
+	int compare(const std::vector<Result> &results, const std::string &baselinePath, double tolerance)
+	{
+		std::ifstream in(baselinePath);
+		if (!in)
+		{
+			std::cout << "ERROR::BENCH: Failed to open baseline " << baselinePath << std::endl;
+			return 1;
+		}
+		std::vector<std::string> lines;
+		std::string line;
+		while (std::getline(in, line))
+			lines.push_back(line);
+
+		int regressions = 0;
+		std::printf("\nCompared with %s (tolerance %.0f%%):\n", baselinePath.c_str(), tolerance);
+		for (const Result &r : results)
+		{
+			auto found = std::find_if(lines.begin(), lines.end(), [&r](const std::string &l) {
+				return l.find("\"scene\": \"" + r.scene + "\"") != std::string::npos;
+			});
+			if (found == lines.end() || !r.ok)
+				continue;
+			for (int m = FIRST_COMPARED; m < METRIC_COUNT; m++)
+			{
+				double before;
+				double now = r.values[m];
+				if (now < 0.0 || !findNumber(*found, METRICS[m], before))
+					continue;
+				std::string metric = METRICS[m];
+				double floor = metric.compare(metric.size() - 3, 3, "_ms") == 0 ? MIN_MS_CHANGE
+				             : metric.compare(metric.size() - 3, 3, "_mb") == 0 ? MIN_MB_CHANGE : 0.0;
+				double change = before > 0.0 ? (now - before) / before * 100.0 : (now > before ? 100.0 : 0.0);
+				bool regressed = change > tolerance && now - before > floor;
+				if (regressed)
+					regressions++;
+				if (regressed || std::fabs(change) > tolerance)
+					std::printf("  %-15s %-20s %12.3f -> %12.3f  %+7.1f%%%s\n", r.scene.c_str(), METRICS[m], before, now,
+					            change, regressed ? "  REGRESSION" : "");
+			}
+		}
+		if (regressions == 0)
+			std::printf("  no regressions\n");
+		return regressions;
+	}
+}
+
+int main(int argc, char const *argv[])
+{
+	Options options = parseOptions(argc, argv);
+
+	const Scene scenes[] = {
+		{"TrianglePoints", TRIANGLE_POINTS_PATH, {}, false},
+		{"TriangleLines", TRIANGLE_LINES_PATH, {}, true},
+		{"Quad", QUAD_PATH, {}, false},
+		// A short sweep; Stress decides its own frame count
+		{"Stress", STRESS_PATH, {"--max-n", "1000", "--step-frames", "10"}, true},
+	};
+
+	std::filesystem::path outDir = options.outDir.empty()
+		? std::filesystem::temp_directory_path() / ("scenebench." + std::to_string(getpid()))
+		: std::filesystem::path(options.outDir);
+	std::error_code error;
+	std::filesystem::create_directories(outDir, error);
+	if (error)
+	{
+		std::cout << "ERROR::BENCH: Failed to create " << outDir << ": " << error.message() << std::endl;
+		return 1;
+	}
+
+	std::vector<Result> results;
+	int failures = 0;
+	std::printf("%-15s %7s %10s %9s %9s %9s %9s %9s %9s %8s %8s\n", "scene", "frames", "startup ms", "cpu p50", "cpu p95",
+	            "cpu p99", "gpu p50", "gpu p95", "gpu p99", "peak MB", "GL live");
+	for (const Scene &scene : scenes)
+	{
+		if (!selected(options, scene.name))
+			continue;
+		if (options.software && !scene.software)
+		{
+			std::printf("%-15s skipped, draws with GL\n", scene.name);
+			continue;
+		}
+		std::string statsPath = (outDir / (std::string(scene.name) + ".json")).string();
+		std::string logPath = (outDir / (std::string(scene.name) + ".log")).string();
+		std::filesystem::remove(statsPath, error);
+
+		double wallMs = 0.0;
+		bool ran = runScene(scene, options, statsPath, logPath, wallMs);
+		Result result = summarize(scene.name, statsPath, wallMs, options.warmup);
+		result.ok = result.ok && ran;
+		results.push_back(result);
+		if (!result.ok)
+		{
+			failures++;
+			std::printf("%-15s failed, see %s\n", scene.name, logPath.c_str());
+			continue;
+		}
+
+		const double *v = result.values;
+		std::printf("%-15s %7.0f %10.1f %9.3f %9.3f %9.3f %9s %9s %9s %8.1f %8s\n", scene.name,
+		            v[metricIndex("frames")], v[metricIndex("startup_ms")],
+		            v[metricIndex("cpu_p50_ms")], v[metricIndex("cpu_p95_ms")], v[metricIndex("cpu_p99_ms")],
+		            formatMetric(v[metricIndex("gpu_p50_ms")], 3).c_str(), formatMetric(v[metricIndex("gpu_p95_ms")], 3).c_str(),
+		            formatMetric(v[metricIndex("gpu_p99_ms")], 3).c_str(), v[metricIndex("peak_rss_mb")],
+		            formatMetric(v[metricIndex("gl_objects_live")], 0).c_str());
+		std::fflush(stdout);
+	}
+	std::printf("Per-frame stats and logs are in %s\n", outDir.string().c_str());
+
+	if (!options.jsonPath.empty() && !writeReport(options.jsonPath, results))
+		failures++;
+	int regressions = options.baselinePath.empty() ? 0 : compare(results, options.baselinePath, options.tolerance);
+	return failures > 0 || regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Canvas.h"
+#include "RenderContext.h"
+#include "textRenderer.h"
+
+// What the host shares with every scene it runs: the context with its canvas
+// and shader library, and the label font. All of it is created once per
+// process, a scene only creates GL objects of its own.
+class SceneResources
+{
+public:
+    explicit SceneResources(RenderContext &context) : context(context) {}
+
+    SceneResources(const SceneResources&) = delete;
+    SceneResources& operator=(const SceneResources&) = delete;
+
+    RenderContext &context;
+
+    // The context's canvas, with the label font loaded on first use
+    Canvas &canvas();
+    // Per-glyph label renderer, with the label font loaded on first use. GL runs only.
+    TextRenderer &text();
+    ShaderLibrary &shaders() { return context.shaders(); }
+
+    // Deletes the shared GL objects; needs the context to still be current
+    void release();
+
+private:
+    TextRenderer textRenderer;
+    bool canvasFontLoaded = false;
+};
+
+// One animation. The host sets every scene of a run up front, so moving to
+// the next one costs nothing, and then calls isUnchanged() and render() once
+// per frame with the time since the scene started.
+class Scene
+{
+public:
+    virtual ~Scene() = default;
+
+    // Creates the scene's own GL objects. `arguments` are the command line
+    // arguments meant for this scene. Returns false if it cannot run.
+    virtual bool setup(SceneResources &resources, const std::vector<std::string> &arguments) = 0;
+    // Seconds the scene takes to play once; a playlist moves on after that
+    virtual double duration() const = 0;
+    // Called before every frame. True if the frame at `time` looks exactly like
+    // the previous frame of this scene, so the host may hold that one instead
+    // of calling render().
+    virtual bool isUnchanged(double time) { return false; }
+    virtual void render(SceneResources &resources, double time) = 0;
+    // Deletes the scene's GL objects while the context is still current
+    virtual void release() = 0;
+    // False if the scene draws through the canvas only and so also runs
+    // under --software, where there is no GL context at all
+    virtual bool needsGl() const { return true; }
+};
+
+// A scene the host can run, by name. `plugin` is the shared object the
+// same scene is built into, for SceneHost --plugins; may be null.
+struct SceneEntry
+{
+    const char *name;
+    std::unique_ptr<Scene> (*create)();
+    const char *plugin = nullptr;
+};
+
+// Put after the factory of a scene. Built with -DANIM_SCENE_PLUGIN (the
+// *Plugin targets), the source then exports the entry point ScenePlugin
+// looks up; everywhere else it expands to nothing.
+#ifdef ANIM_SCENE_PLUGIN
+#define SCENE_PLUGIN_ENTRY(create) \
+    extern "C" __attribute__((visibility("default"))) Scene *animCreateScene() { return create().release(); }
+#else
+#define SCENE_PLUGIN_ENTRY(create)
+#endif
+
+#endif
@@ -0,0 +1,301 @@
+#include "sceneHost.h"
+#include "FileWatcher.h"
+#include "Profiler.h"
+#include "scenePlugin.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace {
+    const int WINDOW_WIDTH = 1920;
+    const int WINDOW_HEIGHT = 1080;
+    const unsigned int LABEL_FONT_SIZE = 48;
+    // A plugin is swapped in once its file has not changed for this long; the
+    // linker creates the file well before it is done writing it
+    const std::chrono::milliseconds PLUGIN_SETTLE_TIME(300);
+
+    struct PlaylistItem
+    {
+        std::string name;
+        // Built-in scenes are created by the entry, plugin scenes from pluginPath
+        const SceneEntry *entry = nullptr;
+        std::string pluginPath;
+        std::vector<std::string> arguments;
+        // Declared before the scene so the scene is destroyed first
+        std::unique_ptr<ScenePlugin> plugin;
+        std::unique_ptr<Scene> scene;
+        double start = 0.0;
+    };
+
+    // Creates the item's scene, from a fresh load of its plugin if it has one,
+    // and sets it up. Leaves `plugin` and `scene` empty on failure.
+    bool createScene(const PlaylistItem &item, SceneResources &resources,
+                     std::unique_ptr<ScenePlugin> &plugin, std::unique_ptr<Scene> &scene)
+    {
+        PROFILE_SCOPE("Scene::setup");
+        if (!item.pluginPath.empty()) {
+            plugin = std::make_unique<ScenePlugin>();
+            if (!plugin->load(item.pluginPath)) {
+                plugin.reset();
+                return false;
+            }
+            scene = plugin->createScene();
+            if (!scene) {
+                std::cout << "ERROR::SCENE_HOST: " << item.pluginPath << " created no scene" << std::endl;
+                plugin.reset();
+                return false;
+            }
+        } else {
+            scene = item.entry->create();
+        }
+
+        if (scene->needsGl() && resources.context.isSoftware()) {
+            std::cout << "ERROR::SCENE_HOST: " << item.name << " draws with GL and cannot run under --software" << std::endl;
+            scene.reset();
+            plugin.reset();
+            return false;
+        }
+        if (!scene->setup(resources, item.arguments)) {
+            std::cout << "ERROR::SCENE_HOST: Failed to set up " << item.name << std::endl;
+            scene->release();
+            scene.reset();
+            plugin.reset();
+            return false;
+        }
+        return true;
+    }
+
+    // Replaces the item's scene with one from the rebuilt plugin. The running
+    // scene stays if the new one cannot be loaded or set up.
+    bool swapScene(PlaylistItem &item, SceneResources &resources)
+    {
+        std::unique_ptr<ScenePlugin> plugin;
+        std::unique_ptr<Scene> scene;
+        if (!createScene(item, resources, plugin, scene)) {
+            std::cout << "ERROR::SCENE_HOST: Keeping the running " << item.name << std::endl;
+            return false;
+        }
+
+        item.scene->release();
+        // The old scene's code lives in the old plugin, which goes second
+        item.scene = std::move(scene);
+        item.plugin = std::move(plugin);
+        std::cout << "Swapped in " << item.pluginPath << std::endl;
+        return true;
+    }
+
+    // Start times follow from the durations, which a swapped scene may change
+    double schedule(std::vector<PlaylistItem> &playlist)
+    {
+        double total = 0.0;
+        for (PlaylistItem &item : playlist) {
+            item.start = total;
+            total += std::max(item.scene->duration(), 0.0);
+        }
+        return total;
+    }
+
+    // Sets every scene up, then draws frames until the run or the playlist
+    // ends. `endless` keeps the last scene going after its duration. Plugins
+    // that are rebuilt meanwhile are swapped in between two frames, the
+    // context with its resources and clock carries on.
+    int play(RenderContext &context, std::vector<PlaylistItem> &playlist, bool loop, bool endless)
+    {
+        SceneResources resources(context);
+        bool ready = true;
+        FileWatcher pluginWatcher;
+        for (PlaylistItem &item : playlist) {
+            if (!createScene(item, resources, item.plugin, item.scene)) {
+                ready = false;
+                break;
+            }
+            if (!item.pluginPath.empty())
+                pluginWatcher.watch(item.pluginPath);
+        }
+
+        if (ready) {
+            double total = schedule(playlist);
+            std::map<std::string, std::chrono::steady_clock::time_point> changedPlugins;
+            context.restartClock();
+            size_t shown = playlist.size();
+            while (!context.shouldClose()) {
+                auto now = std::chrono::steady_clock::now();
+                for (const std::string &path : pluginWatcher.poll())
+                    changedPlugins[path] = now;
+                bool swapped = false;
+                for (auto changed = changedPlugins.begin(); changed != changedPlugins.end(); ) {
+                    if (now - changed->second < PLUGIN_SETTLE_TIME) {
+                        ++changed;
+                        continue;
+                    }
+                    for (PlaylistItem &item : playlist) {
+                        if (item.pluginPath == changed->first)
+                            swapped = swapScene(item, resources) || swapped;
+                    }
+                    changed = changedPlugins.erase(changed);
+                }
+                if (swapped) {
+                    total = schedule(playlist);
+                    // A new scene has no previous frame to hold
+                    shown = playlist.size();
+                }
+
+                double time = context.time();
+                if (loop && total > 0.0)
+                    time = std::fmod(time, total);
+                else if (!endless && time >= total)
+                    break;
+
+                size_t current = 0;
+                while (current + 1 < playlist.size() && time >= playlist[current + 1].start)
+                    current++;
+                PlaylistItem &item = playlist[current];
+                double sceneTime = time - item.start;
+
+                // Only a frame of the same scene can be held
+                bool unchanged = item.scene->isUnchanged(sceneTime);
+                bool switched = current != shown;
+                shown = current;
+                if (unchanged && !switched && context.holdFrame()) {
+                    context.swapBuffers();
+                    continue;
+                }
+                item.scene->render(resources, sceneTime);
+                context.swapBuffers();
+            }
+        }
+
+        for (PlaylistItem &item : playlist) {
+            if (item.scene)
+                item.scene->release();
+        }
+        resources.release();
+        context.destroy();
+        if (!ready)
+            return -1;
+        // What a test run with --alloc-budget checks
+        return context.overAllocationBudget() ? EXIT_FAILURE : 0;
+    }
+
+    const SceneEntry *findScene(const std::vector<SceneEntry> &scenes, const std::string &name)
+    {
+        for (const SceneEntry &scene : scenes) {
+            if (name == scene.name)
+                return &scene;
+        }
+        return nullptr;
+    }
+
+    // In the form FileWatcher reports changed files in
+    std::string pluginPath(const std::string &path)
+    {
+        return std::filesystem::absolute(path).lexically_normal().string();
+    }
+}
+
+Canvas &SceneResources::canvas()
+{
+    Canvas &canvas = context.canvas();
+    // The HUD loads a font of its own into an empty canvas, so the flag decides
+    if (!canvasFontLoaded) {
+        canvasFontLoaded = canvas.loadFont(std::string(RESOURCE_PATH) + "/CuteFont-Regular.ttf", LABEL_FONT_SIZE);
+        if (!canvasFontLoaded)
+            std::cout << "ERROR::SCENE_HOST: Failed to load the label font into the canvas" << std::endl;
+    }
+    return canvas;
+}
+
+TextRenderer &SceneResources::text()
+{
+    if (!textRenderer.isLoaded())
+        textRenderer.loadFont(std::string(RESOURCE_PATH) + "/CuteFont-Regular.ttf", LABEL_FONT_SIZE);
+    return textRenderer;
+}
+
+void SceneResources::release()
+{
+    textRenderer.release();
+}
+
+int runScene(int argc, char const *argv[], const char *title, const SceneEntry &scene)
+{
+    RenderContext context;
+    if (!context.create(argc, argv, title, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return -1;
+    }
+
+    std::vector<PlaylistItem> playlist(1);
+    playlist[0].name = scene.name;
+    playlist[0].entry = &scene;
+    playlist[0].arguments = context.renderOptions().positional;
+    return play(context, playlist, false, true);
+}
+
+int runScenePlaylist(int argc, char const *argv[], const char *title, const std::vector<SceneEntry> &scenes)
+{
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--list") == 0) {
+            for (const SceneEntry &scene : scenes)
+                std::cout << scene.name << std::endl;
+            return 0;
+        }
+    }
+
+    RenderContext context;
+    if (!context.create(argc, argv, title, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return -1;
+    }
+
+    std::vector<PlaylistItem> playlist;
+    bool loop = false;
+    bool plugins = false;
+    for (const std::string &arg : context.renderOptions().positional) {
+        if (arg == "--loop") {
+            loop = true;
+        } else if (arg == "--plugins") {
+            plugins = true;
+        } else if (const SceneEntry *scene = findScene(scenes, arg)) {
+            playlist.emplace_back();
+            playlist.back().name = scene->name;
+            playlist.back().entry = scene;
+        } else if (std::filesystem::path(arg).extension() == ".so") {
+            playlist.emplace_back();
+            playlist.back().name = arg;
+            playlist.back().pluginPath = pluginPath(arg);
+        } else if (!playlist.empty()) {
+            playlist.back().arguments.push_back(arg);
+        } else {
+            std::cout << "ERROR::SCENE_HOST: Unknown scene " << arg << ", --list prints the known ones" << std::endl;
+            context.destroy();
+            return -1;
+        }
+    }
+    if (playlist.empty()) {
+        for (const SceneEntry &scene : scenes) {
+            // Only the scenes that can run without GL; creating one touches no GL
+            if (context.isSoftware() && scene.create()->needsGl())
+                continue;
+            playlist.emplace_back();
+            playlist.back().name = scene.name;
+            playlist.back().entry = &scene;
+        }
+    }
+    if (plugins) {
+        for (PlaylistItem &item : playlist) {
+            if (!item.entry)
+                continue;
+            if (item.entry->plugin)
+                item.pluginPath = pluginPath(item.entry->plugin);
+            else
+                std::cout << "ERROR::SCENE_HOST: " << item.name << " has no plugin build, running the built-in one" << std::endl;
+        }
+    }
+    return play(context, playlist, loop, false);
+}
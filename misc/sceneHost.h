@@ -0,0 +1,31 @@
+#ifndef SCENE_HOST_H
+#define SCENE_HOST_H
+
+#include <vector>
+
+#include "scene.h"
+
+// Runs one scene until the window closes or the frame count is reached, the
+// way each demo executable always did. Positional arguments go to the scene.
+int runScene(int argc, char const *argv[], const char *title, const SceneEntry &scene);
+
+// Runs a playlist of `scenes` back to back in one context:
+//
+//   SceneHost [<scene> | <plugin.so> [<argument>...]]... [--loop] [--plugins] [--list]
+//
+// Each scene plays for its duration, then the next one starts on the following
+// frame. Arguments after a scene name that are not scene names themselves go
+// to that scene. Without names every scene plays in the order given (under
+// --software, every scene that does not need GL). --loop
+// starts over after the last scene, --list prints the names. Scene time is
+// derived from the context clock, so --fps, --range and --workers cut the
+// playlist like a single scene.
+//
+// --plugins runs the named scenes from their plugin modules instead of the
+// copies linked in, and a path to a .so runs the scene module there (see
+// SCENE_PLUGIN_ENTRY). Whenever a module is rebuilt the scene is set up again
+// from the new one and takes over on the next frame, without restarting the
+// clock or reloading fonts and shaders.
+int runScenePlaylist(int argc, char const *argv[], const char *title, const std::vector<SceneEntry> &scenes);
+
+#endif
@@ -0,0 +1,62 @@
+#include "scenePlugin.h"
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    const char *const ENTRY_POINT = "animCreateScene";
+
+    // dlopen hands out the same handle for a path it already has open, so every
+    // load gets a path of its own
+    std::filesystem::path copyPath()
+    {
+        static unsigned int loads = 0;
+        return std::filesystem::temp_directory_path() /
+            ("animScene-" + std::to_string(getpid()) + "-" + std::to_string(loads++) + ".so");
+    }
+}
+
+bool ScenePlugin::load(const std::string &path)
+{
+    unload();
+
+    std::filesystem::path copy = copyPath();
+    std::error_code error;
+    std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, error);
+    if (error) {
+        std::cout << "ERROR::SCENE_PLUGIN: Failed to copy " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // The mapping stays valid after the copy is removed
+    handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    std::filesystem::remove(copy, error);
+    if (!handle) {
+        std::cout << "ERROR::SCENE_PLUGIN: Failed to open " << path << ": " << dlerror() << std::endl;
+        return false;
+    }
+
+    create = reinterpret_cast<Scene *(*)()>(dlsym(handle, ENTRY_POINT));
+    if (!create) {
+        std::cout << "ERROR::SCENE_PLUGIN: " << path << " has no " << ENTRY_POINT << std::endl;
+        unload();
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Scene> ScenePlugin::createScene() const
+{
+    return std::unique_ptr<Scene>(create ? create() : nullptr);
+}
+
+void ScenePlugin::unload()
+{
+    if (handle)
+        dlclose(handle);
+    handle = nullptr;
+    create = nullptr;
+}
@@ -0,0 +1,32 @@
+#ifndef SCENE_PLUGIN_H
+#define SCENE_PLUGIN_H
+
+#include <memory>
+#include <string>
+
+#include "scene.h"
+
+// A scene built as a shared object (see SCENE_PLUGIN_ENTRY). The object is
+// copied before it is opened, so the build can replace the file while the
+// copy is in use and a later load() never gets the cached handle back.
+// Everything the scene uses besides its own code resolves against the host.
+class ScenePlugin
+{
+public:
+    ScenePlugin() = default;
+    ~ScenePlugin() { unload(); }
+
+    ScenePlugin(const ScenePlugin&) = delete;
+    ScenePlugin& operator=(const ScenePlugin&) = delete;
+
+    bool load(const std::string &path);
+    // Every scene created must be destroyed before the plugin is unloaded
+    std::unique_ptr<Scene> createScene() const;
+    void unload();
+
+private:
+    void *handle = nullptr;
+    Scene *(*create)() = nullptr;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+#include <memory>
+
+#include "scene.h"
+
+// Every demo scene, each defined next to its executable
+std::unique_ptr<Scene> createTrianglePointsScene();
+std::unique_ptr<Scene> createTriangleLinesScene();
+std::unique_ptr<Scene> createQuadScene();
+std::unique_ptr<Scene> createMorphScene();
+
+#endif
@@ -1,16 +1,24 @@
 #include "textRenderer.h"
+#include "AllocationTracker.h"
+#include "FrameUniforms.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+#include "Profiler.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
-void TextRenderer::renderText(std::map<GLchar, Character> &Characters, GLuint &VAO, GLuint &VBO, std::string text, float x, float y, float scale, glm::vec3 color)
-{   
-    const char* vertexShaderSource = R"(
+namespace {
+    const char *TEXT_VERTEX_SHADER = R"(
         #version 330 core
         layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
         out vec2 TexCoords;
 
-        uniform mat4 projection;
+        // projection comes from the FrameUniforms block
 
         void main()
         {
@@ -19,7 +27,7 @@ void TextRenderer::renderText(std::map<GLchar, Character> &Characters, GLuint &V
         }
     )";
 
-    const char* fragmentShaderSource = R"(
+    const char *TEXT_FRAGMENT_SHADER = R"(
         #version 330 core
         in vec2 TexCoords;
         out vec4 color;
@@ -33,36 +41,136 @@ void TextRenderer::renderText(std::map<GLchar, Character> &Characters, GLuint &V
             color = vec4(textColor, 1.0) * sampled;
         }
     )";
-    
-        // 1. Compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-
-    // 2. Compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-
-    // 3. Link shaders into program
-    GLuint textShaderProgram = glCreateProgram();
-    glAttachShader(textShaderProgram, vertexShader);
-    glAttachShader(textShaderProgram, fragmentShader);
-    glLinkProgram(textShaderProgram);
-    GLint success;
-    GLchar infoLog[1024];
-    glGetProgramiv(textShaderProgram, GL_LINK_STATUS, &success);
-    if(!success)
+}
+
+bool TextRenderer::loadFont(const std::string &fontPath, unsigned int pixelSize)
+{
+    if (isLoaded() && fontPath == loadedFont && pixelSize == loadedPixelSize)
+        return true;
+    release();
+    GL_RESOURCE_SITE("TextRenderer glyphs");
+
+    // FreeType
+    // --------
+    FT_Library ft;
+    // All functions return a value different than 0 whenever an error occurred
+    if (FT_Init_FreeType(&ft))
+    {
+        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return false;
+    }
+
+    // load font as face
+    FT_Face face;
+    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+        std::cout << "ERROR::FREETYPE: Failed to load font " << fontPath << std::endl;
+        FT_Done_FreeType(ft);
+        return false;
+    }
+    // set size to load glyphs as
+    FT_Set_Pixel_Sizes(face, 0, pixelSize);
+
+    // disable byte-alignment restriction
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // load first 128 characters of ASCII set
+    for (unsigned char c = 0; c < 128; c++)
+    {
+        // Load character glyph 
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+        {
+            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+            continue;
+        }
+        // generate texture
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            GL_RED,
+            face->glyph->bitmap.width,
+            face->glyph->bitmap.rows,
+            0,
+            GL_RED,
+            GL_UNSIGNED_BYTE,
+            face->glyph->bitmap.buffer
+        );
+        // set texture options
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // now store character for later use
+        Character character = {
+            texture,
+            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
+            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
+            static_cast<unsigned int>(face->glyph->advance.x)
+        };
+        Characters.insert(std::pair<char, Character>(c, character));
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    // destroy FreeType once we're finished
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    // One quad, rewritten for every glyph; starts out empty
+    const float emptyQuad[6 * 4] = {};
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(emptyQuad), emptyQuad, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // Linked here rather than on the first label, which would allocate mid-run;
+    // comes from the program cache when it has it
     {
-        glGetProgramInfoLog(textShaderProgram, 1024, NULL, infoLog);
-        std::cout << "PROGRAM_LINKING_ERROR -- TYPE: " << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        PROFILE_SCOPE("TextRenderer::compile");
+        textShaderProgram = loadProgram("TextRenderer", TEXT_VERTEX_SHADER, TEXT_FRAGMENT_SHADER, FRAME_UNIFORMS_GLSL);
+        textColorLocation = glGetUniformLocation(textShaderProgram, "textColor");
+    }
+
+    // Every glyph once as an empty quad, with the state labels are drawn with,
+    // so a software GL builds its shader variants now rather than mid-run
+    {
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glUseProgram(textShaderProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(VAO);
+        for (const auto &character : Characters)
+        {
+            glBindTexture(GL_TEXTURE_2D, character.second.TextureID);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        if (!blend)
+            glDisable(GL_BLEND);
     }
-    
-    // activate corresponding render state	
+
+    loadedFont = fontPath;
+    loadedPixelSize = pixelSize;
+    return true;
+}
+
+void TextRenderer::renderText(const std::string &text, float x, float y, float scale, glm::vec3 color)
+{   
+    if (!isLoaded())
+        return;
+    PROFILE_SCOPE("TextRenderer::renderText");
+    ALLOC_TAG("TextRenderer::renderText");
+
+    // activate corresponding render state; x and y are framebuffer pixels
     glUseProgram(textShaderProgram);
-    glUniform3f(glGetUniformLocation(textShaderProgram, "textColor"), color.x, color.y, color.z);
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(1920), 0.0f, static_cast<float>(1080));
-    glUniformMatrix4fv(glGetUniformLocation(textShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3f(textColorLocation, color.x, color.y, color.z);
     glActiveTexture(GL_TEXTURE0);
     glBindVertexArray(VAO);
 
@@ -103,3 +211,22 @@ void TextRenderer::renderText(std::map<GLchar, Character> &Characters, GLuint &V
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
+
+void TextRenderer::release()
+{
+    for (const auto &character : Characters)
+        glDeleteTextures(1, &character.second.TextureID);
+    Characters.clear();
+    if (VAO)
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+    }
+    VAO = VBO = 0;
+    if (textShaderProgram)
+        glDeleteProgram(textShaderProgram);
+    textShaderProgram = 0;
+    textColorLocation = -1;
+    loadedFont.clear();
+    loadedPixelSize = 0;
+}
@@ -21,11 +21,28 @@ struct Character {
     unsigned int Advance;   // Horizontal offset to advance to next glyph
 };
 
+// Draws labels with one texture per glyph. The font is loaded once and the
+// renderer can be shared by every scene that runs in the same context.
 class TextRenderer{
 
 public:
-    void renderText(std::map<GLchar, Character> &Characters, GLuint &VAO, GLuint &VBO,
-                    std::string text, float x, float y, float scale, glm::vec3 color);
+    // Loads the first 128 characters of the font at `pixelSize` and creates the
+    // quad buffer and the program. Does nothing if that font is loaded already.
+    bool loadFont(const std::string &fontPath, unsigned int pixelSize);
+    bool isLoaded() const { return VAO != 0; }
+
+    // x and y are framebuffer pixels, origin bottom left
+    void renderText(const std::string &text, float x, float y, float scale, glm::vec3 color);
+    // Deletes the glyph textures, buffers and program; call while the GL context is still current
+    void release();
+
+private:
+    std::map<GLchar, Character> Characters;
+    std::string loadedFont;
+    unsigned int loadedPixelSize = 0;
+    GLuint VAO = 0, VBO = 0;
+    GLuint textShaderProgram = 0;
+    GLint textColorLocation = -1;
 };
 
 #endif
\ No newline at end of file
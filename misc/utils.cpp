@@ -1,8 +1,10 @@
 #include "utils.h"
-#include <iostream>
+#include "AllocationTracker.h"
+#include <cmath>
 
 
 std::string glmToText(glm::vec3 point, uint precisionVal){
+  ALLOC_TAG("glmToText");
   std::string pointXtext = std::to_string(point.x).substr(0, std::to_string(point.x).find(".") + precisionVal + 1);
   std::string pointYtext = std::to_string(point.y).substr(0, std::to_string(point.y).find(".") + precisionVal + 1);
   // Not added the Z dim for presentation purposes
@@ -10,12 +12,6 @@ std::string glmToText(glm::vec3 point, uint precisionVal){
   return "(" + pointXtext + ", " + pointYtext + ")";
 }
 
-float normalize_value(float value, float r_min, float r_max, float t_min, float t_max)
-{
-  float normalized_value = (value - r_min) / (r_max - r_min) * (t_max - t_min) + t_min;
-  return normalized_value;
-}
-
 float degreeToRad(float angle)
 {
   return angle * M_PI / 180;
@@ -25,7 +21,6 @@ Point polartToCartesien(float centerX, float centerY, float radius, float angle)
 {
   float radian = degreeToRad(angle);
   Point point;
-  std::cout << "DEBUG Radian: " << radian << std::endl;
   point.x = centerX + radius * cos(radian);
   point.y = centerY + radius * sin(radian);
   return point;
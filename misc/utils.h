@@ -21,7 +21,6 @@ struct Color{
     uint_fast8_t opacity;
 };
 
-float normalize_value(float value, float r_min, float r_max, float t_min, float t_max);
 float degreeToRad(float angle);
 Point polartToCartesien(float centerX, float centerY, float radius, float angle);
 glm::vec2 polarCartesien(const glm::vec2 &point, float angleRadians, float radius);
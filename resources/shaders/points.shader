@@ -0,0 +1,14 @@
+#shader vertex
+#version 330 core
+layout (location = 0) in vec3 aPos;
+void main() {
+    gl_Position = vec4(aPos, 1.0);
+    gl_PointSize = 15.0f; // Size in pixels
+}
+
+#shader fragment
+#version 330 core
+out vec4 FragColor;
+void main() {
+    FragColor = vec4(1.0, 0.5, 0.2, 1.0); // orange
+}
@@ -0,0 +1,380 @@
+#include "AllocationTracker.h"
+
+#ifdef ANIM_TRACK_ALLOCATIONS
+
+#include "Profiler.h"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Nothing on the allocation path may allocate itself: every table below has a
+// fixed size and static storage, so it is zero-initialized before the first
+// operator new runs, whatever the static initialization order.
+namespace {
+	const int MAX_THREADS = 256;
+	const int TAG_SLOTS = 512;
+	const int MAX_BUDGET_MESSAGES = 5;
+	const char *const UNTAGGED = "(untagged)";
+
+	// Written only by its thread, read by the frame and the report
+	struct ThreadSlot
+	{
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> frees;
+		char name[32];
+	};
+
+	struct TagSample
+	{
+		std::atomic<const char*> tag;
+		std::atomic<uint64_t> samples;
+		std::atomic<uint64_t> bytes;
+	};
+
+	ThreadSlot threadSlots[MAX_THREADS];
+	std::atomic<int> threadSlotCount;
+	std::mutex nameMutex;
+	TagSample tagSamples[TAG_SLOTS];
+
+	std::atomic<int64_t> liveBytes;
+	std::atomic<int64_t> peakLiveBytes;
+	std::atomic<int64_t> framePeakLiveBytes;
+
+	thread_local ThreadSlot *tlsSlot = nullptr;
+	thread_local const char *tlsTag = nullptr;
+	thread_local int tlsSampleCountdown = 0;
+
+	// Owned by the render thread
+	struct FrameState
+	{
+		uint64_t allocations = 0, bytes = 0;
+		uint64_t renderAllocations = 0, renderBytes = 0;
+		long frames = 0;
+		long steadyFrames = 0;
+		AllocationFrameStats last;
+		AllocationFrameStats steadyTotals;
+		uint64_t maxRenderAllocations = 0;
+		long maxRenderFrame = -1;
+		long budget = -1;
+		long warmupFrames = 0;
+		long overBudgetFrames = 0;
+		bool exceeded = false;
+	};
+	FrameState frameState;
+
+	ThreadSlot &threadSlot()
+	{
+		if (!tlsSlot)
+		{
+			// Threads past the table share its last slot, hence the atomic counters
+			int index = threadSlotCount.fetch_add(1, std::memory_order_relaxed);
+			tlsSlot = &threadSlots[std::min(index, MAX_THREADS - 1)];
+		}
+		return *tlsSlot;
+	}
+
+	void raiseTo(std::atomic<int64_t> &peak, int64_t value)
+	{
+		int64_t current = peak.load(std::memory_order_relaxed);
+		while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+			;
+	}
+
+	void sample(const char *tag, size_t size)
+	{
+		if (!tag)
+			tag = UNTAGGED;
+		size_t first = (reinterpret_cast<uintptr_t>(tag) >> 3) % TAG_SLOTS;
+		for (size_t i = 0; i < TAG_SLOTS; i++)
+		{
+			TagSample &slot = tagSamples[(first + i) % TAG_SLOTS];
+			const char *current = slot.tag.load(std::memory_order_acquire);
+			if (!current && slot.tag.compare_exchange_strong(current, tag, std::memory_order_acq_rel))
+				current = tag;
+			if (current == tag)
+			{
+				slot.samples.fetch_add(1, std::memory_order_relaxed);
+				slot.bytes.fetch_add(size, std::memory_order_relaxed);
+				return;
+			}
+		}
+	}
+
+	void recordAllocation(void *pointer)
+	{
+		size_t size = malloc_usable_size(pointer);
+		ThreadSlot &slot = threadSlot();
+		slot.allocations.fetch_add(1, std::memory_order_relaxed);
+		slot.bytes.fetch_add(size, std::memory_order_relaxed);
+
+		int64_t live = liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+		raiseTo(framePeakLiveBytes, live);
+		raiseTo(peakLiveBytes, live);
+
+		if (--tlsSampleCountdown <= 0)
+		{
+			tlsSampleCountdown = ALLOCATION_SAMPLE_INTERVAL;
+			sample(tlsTag, size);
+		}
+	}
+
+	void *allocate(size_t size)
+	{
+		void *pointer = std::malloc(size ? size : 1);
+		if (pointer)
+			recordAllocation(pointer);
+		return pointer;
+	}
+
+	void *allocateAligned(size_t size, size_t alignment)
+	{
+		void *pointer = nullptr;
+		if (posix_memalign(&pointer, std::max(alignment, sizeof(void*)), size ? size : 1) != 0)
+			return nullptr;
+		recordAllocation(pointer);
+		return pointer;
+	}
+
+	void release(void *pointer)
+	{
+		if (!pointer)
+			return;
+		liveBytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(pointer)), std::memory_order_relaxed);
+		threadSlot().frees.fetch_add(1, std::memory_order_relaxed);
+		std::free(pointer);
+	}
+}
+
+void *operator new(size_t size)
+{
+	void *pointer = allocate(size);
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+	void *pointer = allocateAligned(size, static_cast<size_t>(alignment));
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, size_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { release(pointer); }
+void operator delete(void *pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { release(pointer); }
+
+AllocationTag::AllocationTag(const char *tag) : previous(tlsTag)
+{
+	tlsTag = tag;
+}
+
+AllocationTag::~AllocationTag()
+{
+	tlsTag = previous;
+}
+
+AllocationBudget::AllocationBudget(const char *name, uint64_t maxAllocations)
+	: name(name), maxAllocations(maxAllocations), start(allocationThreadCount())
+{
+}
+
+AllocationBudget::~AllocationBudget()
+{
+	uint64_t allocations = allocationThreadCount() - start;
+	if (allocations <= maxAllocations)
+		return;
+	frameState.exceeded = true;
+	std::cout << "ERROR::ALLOC: " << name << " allocated " << allocations << " times (budget " << maxAllocations << ")" << std::endl;
+}
+
+void allocationSetThreadName(const std::string &name)
+{
+	ThreadSlot &slot = threadSlot();
+	std::lock_guard<std::mutex> lock(nameMutex);
+	std::snprintf(slot.name, sizeof(slot.name), "%s", name.c_str());
+}
+
+uint64_t allocationThreadCount()
+{
+	return threadSlot().allocations.load(std::memory_order_relaxed);
+}
+
+void allocationSetFrameBudget(long maxPerFrame, long warmupFrames)
+{
+	frameState.budget = maxPerFrame;
+	frameState.warmupFrames = warmupFrames;
+}
+
+void allocationTrackerFrame(long frame)
+{
+	FrameState &state = frameState;
+	uint64_t allocations = 0, bytes = 0;
+	int slots = std::min(threadSlotCount.load(std::memory_order_relaxed), MAX_THREADS);
+	for (int i = 0; i < slots; i++)
+	{
+		allocations += threadSlots[i].allocations.load(std::memory_order_relaxed);
+		bytes += threadSlots[i].bytes.load(std::memory_order_relaxed);
+	}
+	ThreadSlot &render = threadSlot();
+	uint64_t renderAllocations = render.allocations.load(std::memory_order_relaxed);
+	uint64_t renderBytes = render.bytes.load(std::memory_order_relaxed);
+
+	AllocationFrameStats &last = state.last;
+	last.allocations = allocations - state.allocations;
+	last.bytes = bytes - state.bytes;
+	last.renderAllocations = renderAllocations - state.renderAllocations;
+	last.renderBytes = renderBytes - state.renderBytes;
+	last.liveBytes = liveBytes.load(std::memory_order_relaxed);
+	last.peakLiveBytes = framePeakLiveBytes.exchange(last.liveBytes, std::memory_order_relaxed);
+	state.allocations = allocations;
+	state.bytes = bytes;
+	state.renderAllocations = renderAllocations;
+	state.renderBytes = renderBytes;
+	state.frames++;
+
+	PROFILE_COUNTER("heap allocations", static_cast<double>(last.allocations));
+	PROFILE_COUNTER("heap live bytes", static_cast<double>(last.liveBytes));
+
+	if (frame < state.warmupFrames)
+		return;
+
+	state.steadyFrames++;
+	state.steadyTotals.allocations += last.allocations;
+	state.steadyTotals.bytes += last.bytes;
+	state.steadyTotals.renderAllocations += last.renderAllocations;
+	state.steadyTotals.renderBytes += last.renderBytes;
+	state.steadyTotals.peakLiveBytes = std::max(state.steadyTotals.peakLiveBytes, last.peakLiveBytes);
+	if (last.renderAllocations > state.maxRenderAllocations)
+	{
+		state.maxRenderAllocations = last.renderAllocations;
+		state.maxRenderFrame = frame;
+	}
+
+	if (state.budget >= 0 && last.renderAllocations > static_cast<uint64_t>(state.budget))
+	{
+		state.exceeded = true;
+		// Printing may allocate in turn, so only the first few frames are reported
+		if (state.overBudgetFrames++ < MAX_BUDGET_MESSAGES)
+			std::cout << "ERROR::ALLOC: Frame " << frame << " allocated " << last.renderAllocations
+			          << " times on the render thread (budget " << state.budget << ")" << std::endl;
+	}
+}
+
+const AllocationFrameStats &allocationLastFrameStats()
+{
+	return frameState.last;
+}
+
+bool allocationBudgetExceeded()
+{
+	return frameState.exceeded;
+}
+
+void printAllocationReport()
+{
+	const FrameState &state = frameState;
+	if (state.steadyFrames > 0)
+	{
+		double perFrame = 1.0 / state.steadyFrames;
+		std::printf("Heap allocations per frame, averaged over %ld frames after %ld warmup frames:\n",
+		            state.steadyFrames, state.frames - state.steadyFrames);
+		std::printf("  all threads    %10.1f allocations %10.1f KB\n",
+		            state.steadyTotals.allocations * perFrame, state.steadyTotals.bytes * perFrame / 1024.0);
+		std::printf("  render thread  %10.1f allocations %10.1f KB, at most %llu (frame %ld)\n",
+		            state.steadyTotals.renderAllocations * perFrame, state.steadyTotals.renderBytes * perFrame / 1024.0,
+		            static_cast<unsigned long long>(state.maxRenderAllocations), state.maxRenderFrame);
+		std::printf("  live heap high-water mark %.2f MB in steady state, %.2f MB over the run\n",
+		            state.steadyTotals.peakLiveBytes / 1048576.0, peakLiveBytes.load() / 1048576.0);
+	}
+
+	std::printf("Heap allocations per thread over the run:\n");
+	int slots = std::min(threadSlotCount.load(), MAX_THREADS);
+	{
+		std::lock_guard<std::mutex> lock(nameMutex);
+		for (int i = 0; i < slots; i++)
+		{
+			const ThreadSlot &slot = threadSlots[i];
+			std::printf("  %-20s %12llu allocations %12.1f KB %12llu frees\n",
+			            slot.name[0] ? slot.name : (i == MAX_THREADS - 1 ? "other threads" : "unnamed"),
+			            static_cast<unsigned long long>(slot.allocations.load()), slot.bytes.load() / 1024.0,
+			            static_cast<unsigned long long>(slot.frees.load()));
+		}
+	}
+
+	// The same literal may have a different address in every translation unit
+	struct TagTotal
+	{
+		const char *tag;
+		uint64_t samples;
+		uint64_t bytes;
+	};
+	std::vector<TagTotal> tags;
+	for (const TagSample &slot : tagSamples)
+	{
+		const char *tag = slot.tag.load();
+		if (!tag)
+			continue;
+		auto found = std::find_if(tags.begin(), tags.end(), [tag](const TagTotal &total) { return std::strcmp(total.tag, tag) == 0; });
+		if (found == tags.end())
+			tags.push_back({ tag, slot.samples.load(), slot.bytes.load() });
+		else
+		{
+			found->samples += slot.samples.load();
+			found->bytes += slot.bytes.load();
+		}
+	}
+	std::sort(tags.begin(), tags.end(), [](const TagTotal &a, const TagTotal &b) { return a.samples > b.samples; });
+	if (!tags.empty())
+	{
+		std::printf("Sampled allocation sites, 1 allocation in %d:\n", ALLOCATION_SAMPLE_INTERVAL);
+		for (const TagTotal &total : tags)
+			std::printf("  %-28s ~%10llu allocations ~%10.1f KB\n", total.tag,
+			            static_cast<unsigned long long>(total.samples * ALLOCATION_SAMPLE_INTERVAL),
+			            total.bytes * ALLOCATION_SAMPLE_INTERVAL / 1024.0);
+	}
+
+	if (state.overBudgetFrames > 0)
+		std::cout << "ERROR::ALLOC: " << state.overBudgetFrames << " of " << state.steadyFrames
+		          << " frames went over the budget of " << state.budget << " allocations" << std::endl;
+}
+
+#endif
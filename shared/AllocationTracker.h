@@ -0,0 +1,98 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+// Heap allocation accounting. Configure with -DANIM_TRACK_ALLOCATIONS=ON to
+// replace the global operator new and delete with versions that count every
+// allocation; otherwise the macros below expand to nothing and the default
+// allocator is used.
+//
+//   ALLOC_TAG("glmToText");            attributes sampled allocations in the block
+//   ALLOC_BUDGET("draw", 0);           reports the block if it allocates more often
+//   ALLOC_THREAD_NAME("encoder");      names the calling thread in the report
+//
+// Counters are kept per thread and folded into per-frame numbers by
+// RenderContext::swapBuffers: allocations, bytes and the high-water mark of
+// live heap bytes. One allocation in ALLOCATION_SAMPLE_INTERVAL per thread is
+// attributed to the innermost ALLOC_TAG around it, which is enough to find
+// the hot spots without paying for a lookup on every call.
+//
+// Run a scene with --alloc-stats for a report at exit. --alloc-budget <n>
+// fails the run (exit code 1) if, once the warmup frames are over, a frame
+// allocates more than n times on the render thread; --alloc-budget 0 asserts
+// an allocation-free steady state.
+
+#include <cstdint>
+
+struct AllocationFrameStats
+{
+	uint64_t allocations = 0;       // every thread
+	uint64_t bytes = 0;
+	uint64_t renderAllocations = 0; // the thread calling allocationTrackerFrame
+	uint64_t renderBytes = 0;
+	int64_t liveBytes = 0;          // at the end of the frame
+	int64_t peakLiveBytes = 0;      // high-water mark during the frame
+};
+
+#ifdef ANIM_TRACK_ALLOCATIONS
+
+#include <string>
+
+const int ALLOCATION_SAMPLE_INTERVAL = 64;
+
+class AllocationTag
+{
+public:
+	explicit AllocationTag(const char *tag);
+	~AllocationTag();
+
+	AllocationTag(const AllocationTag&) = delete;
+	AllocationTag& operator=(const AllocationTag&) = delete;
+
+private:
+	const char *previous;
+};
+
+class AllocationBudget
+{
+public:
+	AllocationBudget(const char *name, uint64_t maxAllocations);
+	~AllocationBudget();
+
+	AllocationBudget(const AllocationBudget&) = delete;
+	AllocationBudget& operator=(const AllocationBudget&) = delete;
+
+private:
+	const char *name;
+	uint64_t maxAllocations;
+	uint64_t start;
+};
+
+void allocationSetThreadName(const std::string &name);
+// Allocations made by the calling thread since it started.
+uint64_t allocationThreadCount();
+// Frames numbered below `warmupFrames` may allocate freely; negative
+// `maxPerFrame` turns the budget off.
+void allocationSetFrameBudget(long maxPerFrame, long warmupFrames);
+// Called once per frame on the render thread. Closes the frame's counters
+// and checks them against the budget.
+void allocationTrackerFrame(long frame);
+const AllocationFrameStats &allocationLastFrameStats();
+// True once a frame or an ALLOC_BUDGET block went over its budget.
+bool allocationBudgetExceeded();
+void printAllocationReport();
+
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_TAG(tag) AllocationTag ALLOC_CONCAT(allocationTag, __LINE__)(tag)
+#define ALLOC_BUDGET(name, maxAllocations) AllocationBudget ALLOC_CONCAT(allocationBudget, __LINE__)(name, maxAllocations)
+#define ALLOC_THREAD_NAME(name) allocationSetThreadName(name)
+
+#else
+
+#define ALLOC_TAG(tag) ((void)0)
+#define ALLOC_BUDGET(name, maxAllocations) ((void)0)
+#define ALLOC_THREAD_NAME(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <cstddef>
+#include <string>
+
+#include <glm/glm/glm.hpp>
+
+// Backend independent 2D drawing used by scenes that should also render
+// without GL. Geometry is given in NDC like the demos' vertex data, text in
+// pixels with the origin at the bottom-left like TextRenderer::renderText.
+// Draws are blended with source-over alpha in call order.
+class Canvas
+{
+public:
+	virtual ~Canvas() = default;
+
+	virtual bool loadFont(const std::string &fontPath, unsigned int pixelSize) = 0;
+
+	virtual void clear(const glm::vec4 &color) = 0;
+	// Square points, sizeInPixels wide, like gl_PointSize
+	virtual void drawPoints(const glm::vec3 *points, size_t count, float sizeInPixels, const glm::vec4 &color) = 0;
+	// GL_LINES pairs, widthInPixels wide
+	virtual void drawLines(const glm::vec3 *points, size_t count, float widthInPixels, const glm::vec4 &color) = 0;
+	// GL_TRIANGLES list
+	virtual void drawTriangles(const glm::vec3 *points, size_t count, const glm::vec4 &color) = 0;
+	// Lines of a multi-line `text` are GlyphAtlas::LINE_SPACING font sizes apart
+	virtual void drawText(const std::string &text, float x, float y, float scale, const glm::vec3 &color) = 0;
+	// Pixel size the font was loaded with, 0 before loadFont succeeded
+	virtual unsigned int fontPixelSize() const = 0;
+
+	// Finishes the frame. The software canvas rasterizes here.
+	virtual void flush() = 0;
+
+	virtual int width() const = 0;
+	virtual int height() const = 0;
+};
+
+#endif
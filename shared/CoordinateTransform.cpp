@@ -0,0 +1,93 @@
+#include "CoordinateTransform.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+CoordinateTransform CoordinateTransform::ndcToPixels(int width, int height)
+{
+	glm::vec2 half(0.5f * width, 0.5f * height);
+	return CoordinateTransform(glm::mat2(half.x, 0.0f, 0.0f, half.y), half);
+}
+
+CoordinateTransform CoordinateTransform::pixelsToNdc(int width, int height)
+{
+	return ndcToPixels(width, height).inverse();
+}
+
+CoordinateTransform CoordinateTransform::worldToNdc(const glm::vec2 &min, const glm::vec2 &max)
+{
+	glm::vec2 scale = 2.0f / (max - min);
+	return CoordinateTransform(glm::mat2(scale.x, 0.0f, 0.0f, scale.y), -1.0f - min * scale);
+}
+
+CoordinateTransform CoordinateTransform::inverse() const
+{
+	glm::mat2 inverseLinear = glm::inverse(linear);
+	return CoordinateTransform(inverseLinear, -(inverseLinear * offset));
+}
+
+CoordinateTransform CoordinateTransform::operator*(const CoordinateTransform &first) const
+{
+	return CoordinateTransform(linear * first.linear, linear * first.offset + offset);
+}
+
+void CoordinateTransform::apply(const glm::vec2 *in, glm::vec2 *out, size_t count) const
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	// Two interleaved points per register: x' = m00 x + m10 y + ox, and the
+	// m10 and m01 terms come from the register with x and y swapped
+	const float *src = &in[0].x;
+	float *dst = &out[0].x;
+	__m128 diagonal = _mm_setr_ps(linear[0][0], linear[1][1], linear[0][0], linear[1][1]);
+	__m128 crossed = _mm_setr_ps(linear[1][0], linear[0][1], linear[1][0], linear[0][1]);
+	__m128 translation = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 a = _mm_loadu_ps(src + 2 * i);
+		__m128 b = _mm_loadu_ps(src + 2 * i + 4);
+		__m128 aSwapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 bSwapped = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+		a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, diagonal), _mm_mul_ps(aSwapped, crossed)), translation);
+		b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, diagonal), _mm_mul_ps(bSwapped, crossed)), translation);
+		_mm_storeu_ps(dst + 2 * i, a);
+		_mm_storeu_ps(dst + 2 * i + 4, b);
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = apply(in[i]);
+}
+
+void CoordinateTransform::apply(const glm::vec3 *in, glm::vec2 *out, size_t count) const
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	// Four points are three registers, x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3,
+	// split into x and y lanes, mapped, and interleaved again as vec2
+	const float *src = &in[0].x;
+	float *dst = &out[0].x;
+	__m128 m00 = _mm_set1_ps(linear[0][0]), m01 = _mm_set1_ps(linear[0][1]);
+	__m128 m10 = _mm_set1_ps(linear[1][0]), m11 = _mm_set1_ps(linear[1][1]);
+	__m128 ox = _mm_set1_ps(offset.x), oy = _mm_set1_ps(offset.y);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 a = _mm_loadu_ps(src + 3 * i);
+		__m128 b = _mm_loadu_ps(src + 3 * i + 4);
+		__m128 c = _mm_loadu_ps(src + 3 * i + 8);
+
+		__m128 xTail = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 0, 2));      // x2 y1 x3 y3
+		__m128 x = _mm_shuffle_ps(a, xTail, _MM_SHUFFLE(2, 0, 3, 0));      // x0 x1 x2 x3
+		__m128 yHead = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));      // y0 y0 y1 y1
+		__m128 yTail = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));      // y2 y2 y3 y3
+		__m128 y = _mm_shuffle_ps(yHead, yTail, _MM_SHUFFLE(2, 0, 2, 0));  // y0 y1 y2 y3
+
+		__m128 mappedX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), ox);
+		__m128 mappedY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), oy);
+		_mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(mappedX, mappedY));
+		_mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(mappedX, mappedY));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = apply(glm::vec2(in[i]));
+}
@@ -0,0 +1,46 @@
+#ifndef COORDINATE_TRANSFORM_H
+#define COORDINATE_TRANSFORM_H
+
+#include <cstddef>
+
+#include <glm/glm/glm.hpp>
+
+// 2D affine map p' = linear * p + offset between the spaces the scenes work
+// in: NDC like the vertex data, framebuffer pixels with the origin at the
+// bottom-left like Canvas::drawText, and world rectangles that fill the
+// viewport. The matrix is built once and then applied to whole arrays, so
+// placing many labels costs one pass instead of two divisions per coordinate.
+class CoordinateTransform
+{
+public:
+	// Identity
+	CoordinateTransform() = default;
+	CoordinateTransform(const glm::mat2 &linear, const glm::vec2 &offset) : linear(linear), offset(offset) {}
+
+	// NDC [-1, 1] onto a width x height framebuffer; pass RenderContext::width()
+	// and height() or the canvas size, which follow the real framebuffer
+	static CoordinateTransform ndcToPixels(int width, int height);
+	static CoordinateTransform pixelsToNdc(int width, int height);
+	// The world rectangle [min, max] onto NDC [-1, 1]
+	static CoordinateTransform worldToNdc(const glm::vec2 &min, const glm::vec2 &max);
+
+	// Undefined for a singular map
+	CoordinateTransform inverse() const;
+	// Applies `first`, then this
+	CoordinateTransform operator*(const CoordinateTransform &first) const;
+
+	glm::vec2 apply(const glm::vec2 &p) const { return linear * p + offset; }
+	// Bulk versions, SSE2 where available. The z of vec3 points is ignored.
+	// `in` and `out` may be the same array.
+	void apply(const glm::vec2 *in, glm::vec2 *out, size_t count) const;
+	void apply(const glm::vec3 *in, glm::vec2 *out, size_t count) const;
+
+	const glm::mat2 &linearPart() const { return linear; }
+	const glm::vec2 &offsetPart() const { return offset; }
+
+private:
+	glm::mat2 linear = glm::mat2(1.0f);
+	glm::vec2 offset = glm::vec2(0.0f);
+};
+
+#endif
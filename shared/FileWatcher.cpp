@@ -0,0 +1,80 @@
+#include "FileWatcher.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+FileWatcher::FileWatcher()
+{
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0)
+		std::cout << "ERROR::FILEWATCHER: inotify_init1 failed" << std::endl;
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (inotifyFd >= 0)
+		close(inotifyFd);
+}
+
+bool FileWatcher::watch(const std::string &path)
+{
+	if (inotifyFd < 0)
+		return false;
+
+	std::filesystem::path absolute = std::filesystem::absolute(path).lexically_normal();
+	std::string directory = absolute.parent_path().string();
+
+	bool directoryWatched = std::any_of(directories.begin(), directories.end(),
+		[&directory](const auto &entry) { return entry.second == directory; });
+	if (!directoryWatched)
+	{
+		int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0)
+		{
+			std::cout << "ERROR::FILEWATCHER: Failed to watch " << directory << std::endl;
+			return false;
+		}
+		directories[wd] = directory;
+	}
+	files.insert(absolute.string());
+	return true;
+}
+
+void FileWatcher::unwatch(const std::string &path)
+{
+	files.erase(std::filesystem::absolute(path).lexically_normal().string());
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+	std::vector<std::string> changed;
+	if (inotifyFd < 0)
+		return changed;
+
+	alignas(inotify_event) char buffer[4096];
+	while (true)
+	{
+		ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+
+		for (char *ptr = buffer; ptr < buffer + length; )
+		{
+			const inotify_event *event = reinterpret_cast<const inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+
+			auto directory = directories.find(event->wd);
+			if (directory == directories.end() || event->len == 0)
+				continue;
+
+			std::string file = directory->second + "/" + event->name;
+			if (files.count(file) && std::find(changed.begin(), changed.end(), file) == changed.end())
+				changed.push_back(file);
+		}
+	}
+	return changed;
+}
@@ -0,0 +1,32 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Non-blocking inotify watcher. The parent directory of every watched file is
+// observed rather than the file itself, so editors that save by writing a new
+// file and renaming it over the old one are still picked up.
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool watch(const std::string &path);
+	void unwatch(const std::string &path);
+	// Returns the watched files that changed since the last call. Never blocks.
+	std::vector<std::string> poll();
+
+private:
+	int inotifyFd = -1;
+	std::map<int, std::string> directories;  // watch descriptor -> directory
+	std::set<std::string> files;             // absolute paths of watched files
+};
+
+#endif
@@ -0,0 +1,596 @@
+#include "FrameEncoders.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+	// BT.709 limited range, 8.8 fixed point
+	const int Y_R = 47, Y_G = 157, Y_B = 16;
+	const int U_R = -26, U_G = -87, U_B = 112;
+	const int V_R = 112, V_G = -102, V_B = -10;
+
+	inline unsigned char clampByte(int value)
+	{
+		return static_cast<unsigned char>(std::min(255, std::max(0, value)));
+	}
+
+	inline const unsigned char *sourceRow(const Frame &frame, int topDownRow)
+	{
+		// Frames are bottom-up
+		return frame.pixels.data() + static_cast<size_t>(frame.height - 1 - topDownRow) * frame.width * 4;
+	}
+
+	void putBigEndian32(std::vector<unsigned char> &bytes, uint32_t value)
+	{
+		bytes.push_back(static_cast<unsigned char>(value >> 24));
+		bytes.push_back(static_cast<unsigned char>(value >> 16));
+		bytes.push_back(static_cast<unsigned char>(value >> 8));
+		bytes.push_back(static_cast<unsigned char>(value));
+	}
+
+#ifdef __SSE2__
+	// Dot product of four RGBA8 pixels with (cr, cg, cb, 0), as four int32 lanes
+	inline __m128i weightedSum4(__m128i pixels, __m128i coefficients)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients);
+		__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients);
+		__m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+		return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+	}
+
+	inline __m128i scaleAndBias(__m128i sum, int offset)
+	{
+		return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8), _mm_set1_epi32(offset));
+	}
+#endif
+
+	// Flips a bottom-up RGBA frame into top-down RGB24 rows, each optionally
+	// preceded by a PNG filter byte.
+	void packRgbRows(const Frame &frame, unsigned char *out, bool filterBytes)
+	{
+		for (int row = 0; row < frame.height; row++)
+		{
+			const unsigned char *src = sourceRow(frame, row);
+			if (filterBytes)
+				*out++ = 0;
+			for (int x = 0; x < frame.width; x++)
+			{
+				out[0] = src[x * 4 + 0];
+				out[1] = src[x * 4 + 1];
+				out[2] = src[x * 4 + 2];
+				out += 3;
+			}
+		}
+	}
+
+	// Deflate
+	// -------
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<unsigned char> &bytes) : bytes(bytes) {}
+
+		void put(uint32_t bits, int count)
+		{
+			buffer |= static_cast<uint64_t>(bits) << used;
+			used += count;
+			while (used >= 8)
+			{
+				bytes.push_back(static_cast<unsigned char>(buffer));
+				buffer >>= 8;
+				used -= 8;
+			}
+		}
+
+		// Huffman codes are stored most significant bit first
+		void putCode(uint32_t code, int length)
+		{
+			uint32_t reversed = 0;
+			for (int i = 0; i < length; i++)
+				reversed |= ((code >> i) & 1u) << (length - 1 - i);
+			put(reversed, length);
+		}
+
+		void flush()
+		{
+			if (used > 0)
+				bytes.push_back(static_cast<unsigned char>(buffer));
+			buffer = 0;
+			used = 0;
+		}
+
+	private:
+		std::vector<unsigned char> &bytes;
+		uint64_t buffer = 0;
+		int used = 0;
+	};
+
+	const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	                                   3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	                                     257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	                                     7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	void putLiteralLength(BitWriter &writer, int symbol)
+	{
+		if (symbol < 144)
+			writer.putCode(0x30 + symbol, 8);
+		else if (symbol < 256)
+			writer.putCode(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			writer.putCode(symbol - 256, 7);
+		else
+			writer.putCode(0xc0 + symbol - 280, 8);
+	}
+
+	void putMatch(BitWriter &writer, int length, int distance)
+	{
+		int lengthCode = 28;
+		while (LENGTH_BASE[lengthCode] > length)
+			lengthCode--;
+		putLiteralLength(writer, 257 + lengthCode);
+		writer.put(length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+		int distanceCode = 29;
+		while (DISTANCE_BASE[distanceCode] > distance)
+			distanceCode--;
+		writer.putCode(distanceCode, 5);
+		writer.put(distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+	}
+
+	// Single fixed-Huffman block. Each position probes one hash table slot for
+	// an earlier occurrence of its next three bytes.
+	void deflateFixed(const unsigned char *data, size_t size, std::vector<unsigned char> &bytes)
+	{
+		const int HASH_BITS = 15;
+		const size_t WINDOW = 32768;
+		std::vector<int64_t> table(size_t(1) << HASH_BITS, -1);
+
+		BitWriter writer(bytes);
+		writer.put(1, 1);   // BFINAL
+		writer.put(1, 2);   // BTYPE = fixed Huffman
+		size_t i = 0;
+		while (i < size)
+		{
+			if (i + 3 <= size)
+			{
+				uint32_t sequence = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+				uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+				int64_t candidate = table[hash];
+				table[hash] = static_cast<int64_t>(i);
+				if (candidate >= 0 && i - candidate <= WINDOW &&
+				    std::memcmp(data + candidate, data + i, 3) == 0)
+				{
+					size_t limit = std::min<size_t>(258, size - i);
+					size_t length = 3;
+					while (length < limit && data[candidate + length] == data[i + length])
+						length++;
+					putMatch(writer, static_cast<int>(length), static_cast<int>(i - candidate));
+					i += length;
+					continue;
+				}
+			}
+			putLiteralLength(writer, data[i]);
+			i++;
+		}
+		putLiteralLength(writer, 256);
+		writer.flush();
+	}
+
+	uint32_t adler32(const unsigned char *data, size_t size)
+	{
+		uint32_t a = 1, b = 0;
+		while (size > 0)
+		{
+			size_t chunk = std::min<size_t>(size, 5552);
+			size -= chunk;
+			while (chunk--)
+			{
+				a += *data++;
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	uint32_t crc32(const unsigned char *data, size_t size, uint32_t crc = 0)
+	{
+		static const std::vector<uint32_t> table = []() {
+			std::vector<uint32_t> t(256);
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				t[n] = c;
+			}
+			return t;
+		}();
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+			crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	void putPngChunk(std::vector<unsigned char> &bytes, const char *type, const unsigned char *data, size_t size)
+	{
+		putBigEndian32(bytes, static_cast<uint32_t>(size));
+		size_t start = bytes.size();
+		bytes.insert(bytes.end(), type, type + 4);
+		bytes.insert(bytes.end(), data, data + size);
+		putBigEndian32(bytes, crc32(bytes.data() + start, size + 4));
+	}
+}
+
+void convertRgbaToI420(const Frame &frame, unsigned char *yPlane, unsigned char *uPlane, unsigned char *vPlane)
+{
+	const int width = frame.width, height = frame.height;
+	const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+
+	for (int row = 0; row < height; row++)
+	{
+		const unsigned char *src = sourceRow(frame, row);
+		unsigned char *dst = yPlane + static_cast<size_t>(row) * width;
+		int x = 0;
+#ifdef __SSE2__
+		const __m128i coefficients = _mm_setr_epi16(Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0);
+		for (; x + 8 <= width; x += 8)
+		{
+			__m128i y0 = scaleAndBias(weightedSum4(_mm_loadu_si128((const __m128i*)(src + x * 4)), coefficients), 16);
+			__m128i y1 = scaleAndBias(weightedSum4(_mm_loadu_si128((const __m128i*)(src + x * 4 + 16)), coefficients), 16);
+			__m128i packed = _mm_packs_epi32(y0, y1);
+			_mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(packed, packed));
+		}
+#endif
+		for (; x < width; x++)
+		{
+			const unsigned char *p = src + x * 4;
+			dst[x] = clampByte(((Y_R * p[0] + Y_G * p[1] + Y_B * p[2] + 128) >> 8) + 16);
+		}
+	}
+
+	for (int row = 0; row < chromaHeight; row++)
+	{
+		const unsigned char *top = sourceRow(frame, row * 2);
+		const unsigned char *bottom = sourceRow(frame, std::min(row * 2 + 1, height - 1));
+		unsigned char *uDst = uPlane + static_cast<size_t>(row) * chromaWidth;
+		unsigned char *vDst = vPlane + static_cast<size_t>(row) * chromaWidth;
+		int x = 0;
+#ifdef __SSE2__
+		const __m128i uCoefficients = _mm_setr_epi16(U_R, U_G, U_B, 0, U_R, U_G, U_B, 0);
+		const __m128i vCoefficients = _mm_setr_epi16(V_R, V_G, V_B, 0, V_R, V_G, V_B, 0);
+		for (; x + 8 <= width; x += 8)
+		{
+			// Average 2x2 blocks: rows first, then neighbouring pixels
+			__m128i a = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(top + x * 4)),
+			                         _mm_loadu_si128((const __m128i*)(bottom + x * 4)));
+			__m128i b = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(top + x * 4 + 16)),
+			                         _mm_loadu_si128((const __m128i*)(bottom + x * 4 + 16)));
+			a = _mm_avg_epu8(a, _mm_srli_si128(a, 4));
+			b = _mm_avg_epu8(b, _mm_srli_si128(b, 4));
+			__m128i blocks = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+
+			__m128i u = scaleAndBias(weightedSum4(blocks, uCoefficients), 128);
+			__m128i v = scaleAndBias(weightedSum4(blocks, vCoefficients), 128);
+			u = _mm_packs_epi32(u, u);
+			v = _mm_packs_epi32(v, v);
+			int uBytes = _mm_cvtsi128_si32(_mm_packus_epi16(u, u));
+			int vBytes = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+			std::memcpy(uDst + x / 2, &uBytes, 4);
+			std::memcpy(vDst + x / 2, &vBytes, 4);
+		}
+#endif
+		for (; x < width; x += 2)
+		{
+			int x1 = std::min(x + 1, width - 1);
+			int r = (top[x * 4 + 0] + top[x1 * 4 + 0] + bottom[x * 4 + 0] + bottom[x1 * 4 + 0] + 2) >> 2;
+			int g = (top[x * 4 + 1] + top[x1 * 4 + 1] + bottom[x * 4 + 1] + bottom[x1 * 4 + 1] + 2) >> 2;
+			int b = (top[x * 4 + 2] + top[x1 * 4 + 2] + bottom[x * 4 + 2] + bottom[x1 * 4 + 2] + 2) >> 2;
+			uDst[x / 2] = clampByte(((U_R * r + U_G * g + U_B * b + 128) >> 8) + 128);
+			vDst[x / 2] = clampByte(((V_R * r + V_G * g + V_B * b + 128) >> 8) + 128);
+		}
+	}
+}
+
+void encodeQoi(const Frame &frame, std::vector<unsigned char> &bytes)
+{
+	bytes.clear();
+	bytes.reserve(static_cast<size_t>(frame.width) * frame.height + 64);
+	bytes.insert(bytes.end(), {'q', 'o', 'i', 'f'});
+	putBigEndian32(bytes, static_cast<uint32_t>(frame.width));
+	putBigEndian32(bytes, static_cast<uint32_t>(frame.height));
+	bytes.push_back(3);   // RGB
+	bytes.push_back(0);   // sRGB
+
+	struct Pixel { unsigned char r, g, b, a; };
+	Pixel index[64] = {};
+	Pixel previous = {0, 0, 0, 255};
+	int run = 0;
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+	size_t written = 0;
+
+	for (int row = 0; row < frame.height; row++)
+	{
+		const unsigned char *src = sourceRow(frame, row);
+		for (int x = 0; x < frame.width; x++, written++)
+		{
+			Pixel pixel = {src[x * 4], src[x * 4 + 1], src[x * 4 + 2], 255};
+			bool same = pixel.r == previous.r && pixel.g == previous.g && pixel.b == previous.b;
+			if (same)
+			{
+				run++;
+				if (run == 62 || written + 1 == pixelCount)
+				{
+					bytes.push_back(static_cast<unsigned char>(0xc0 | (run - 1)));
+					run = 0;
+				}
+				continue;
+			}
+			if (run > 0)
+			{
+				bytes.push_back(static_cast<unsigned char>(0xc0 | (run - 1)));
+				run = 0;
+			}
+
+			int hash = (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64;
+			const Pixel &cached = index[hash];
+			if (cached.r == pixel.r && cached.g == pixel.g && cached.b == pixel.b && cached.a == pixel.a)
+			{
+				bytes.push_back(static_cast<unsigned char>(hash));
+			}
+			else
+			{
+				index[hash] = pixel;
+				signed char dr = static_cast<signed char>(pixel.r - previous.r);
+				signed char dg = static_cast<signed char>(pixel.g - previous.g);
+				signed char db = static_cast<signed char>(pixel.b - previous.b);
+				signed char drg = static_cast<signed char>(dr - dg);
+				signed char dbg = static_cast<signed char>(db - dg);
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					bytes.push_back(static_cast<unsigned char>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+				}
+				else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+				{
+					bytes.push_back(static_cast<unsigned char>(0x80 | (dg + 32)));
+					bytes.push_back(static_cast<unsigned char>((drg + 8) << 4 | (dbg + 8)));
+				}
+				else
+				{
+					bytes.insert(bytes.end(), {0xfe, pixel.r, pixel.g, pixel.b});
+				}
+			}
+			previous = pixel;
+		}
+	}
+	bytes.insert(bytes.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+}
+
+void encodePng(const Frame &frame, std::vector<unsigned char> &bytes)
+{
+	thread_local std::vector<unsigned char> raw;
+	thread_local std::vector<unsigned char> compressed;
+	raw.resize(static_cast<size_t>(frame.width * 3 + 1) * frame.height);
+	packRgbRows(frame, raw.data(), true);
+
+	compressed.clear();
+	compressed.push_back(0x78);   // zlib header: deflate, 32K window
+	compressed.push_back(0x01);
+	deflateFixed(raw.data(), raw.size(), compressed);
+	putBigEndian32(compressed, adler32(raw.data(), raw.size()));
+
+	bytes.clear();
+	const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	bytes.insert(bytes.end(), signature, signature + 8);
+
+	std::vector<unsigned char> header;
+	putBigEndian32(header, static_cast<uint32_t>(frame.width));
+	putBigEndian32(header, static_cast<uint32_t>(frame.height));
+	header.insert(header.end(), {8, 2, 0, 0, 0});   // 8 bit RGB, no interlace
+	putPngChunk(bytes, "IHDR", header.data(), header.size());
+	putPngChunk(bytes, "IDAT", compressed.data(), compressed.size());
+	putPngChunk(bytes, "IEND", nullptr, 0);
+}
+
+ImageSequenceSink::ImageSequenceSink(const std::string &pattern, ImageFormat format)
+	: pattern(pattern), format(format)
+{
+	std::filesystem::path directory = std::filesystem::path(pattern).parent_path();
+	if (!directory.empty())
+		std::filesystem::create_directories(directory);
+}
+
+std::string ImageSequenceSink::framePath(long frameIndex) const
+{
+	char path[4096];
+	std::snprintf(path, sizeof(path), pattern.c_str(), frameIndex);
+	return path;
+}
+
+bool ImageSequenceSink::writeFrame(Frame &frame)
+{
+	std::string path = framePath(frame.index);
+
+	thread_local std::vector<unsigned char> bytes;
+	bytes.clear();
+	switch (format)
+	{
+	case ImageFormat::Ppm:
+	{
+		char header[64];
+		int headerSize = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", frame.width, frame.height);
+		bytes.resize(headerSize + static_cast<size_t>(frame.width) * frame.height * 3);
+		std::memcpy(bytes.data(), header, headerSize);
+		packRgbRows(frame, bytes.data() + headerSize, false);
+		break;
+	}
+	case ImageFormat::Qoi:
+		encodeQoi(frame, bytes);
+		break;
+	case ImageFormat::Png:
+		encodePng(frame, bytes);
+		break;
+	}
+
+	// A previous export may have left a symlink here, never write through it
+	std::error_code error;
+	std::filesystem::remove(path, error);
+	FILE *file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		std::cout << "ERROR::EXPORT: Failed to open " << path << std::endl;
+		return false;
+	}
+	std::fwrite(bytes.data(), 1, bytes.size(), file);
+	return std::fclose(file) == 0;
+}
+
+bool ImageSequenceSink::writeDuplicate(long frameIndex, long sourceIndex)
+{
+	std::filesystem::path link = framePath(frameIndex);
+	std::filesystem::path target = std::filesystem::path(framePath(sourceIndex)).filename();
+	std::error_code error;
+	std::filesystem::remove(link, error);
+	std::filesystem::create_symlink(target, link, error);
+	if (error)
+	{
+		std::cout << "ERROR::EXPORT: Failed to link " << link << " to " << target << ": " << error.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+OrderedStreamSink::OrderedStreamSink(const std::string &target) : target(target)
+{
+}
+
+OrderedStreamSink::~OrderedStreamSink()
+{
+	finish();
+}
+
+void OrderedStreamSink::begin(int width, int height, long firstFrame)
+{
+	nextFrame = firstFrame;
+	isPipe = !target.empty() && target[0] == '|';
+	stream = isPipe ? popen(target.c_str() + 1, "w") : std::fopen(target.c_str(), "wb");
+	if (!stream)
+	{
+		std::cout << "ERROR::EXPORT: Failed to open " << target << std::endl;
+		return;
+	}
+	std::string header = streamHeader(width, height);
+	std::fwrite(header.data(), 1, header.size(), stream);
+}
+
+bool OrderedStreamSink::writeFrame(Frame &frame)
+{
+	PendingFrame converted;
+	{
+		std::lock_guard<std::mutex> lock(writeMutex);
+		if (!spareBuffers.empty())
+		{
+			converted.bytes = std::move(spareBuffers.back());
+			spareBuffers.pop_back();
+		}
+	}
+	encode(frame, converted.bytes);
+	return queueFrame(frame.index, std::move(converted));
+}
+
+bool OrderedStreamSink::writeDuplicate(long frameIndex, long sourceIndex)
+{
+	PendingFrame duplicate;
+	duplicate.duplicate = true;
+	return queueFrame(frameIndex, std::move(duplicate));
+}
+
+bool OrderedStreamSink::queueFrame(long frameIndex, PendingFrame &&frame)
+{
+	std::lock_guard<std::mutex> lock(writeMutex);
+	if (!stream)
+		return false;
+	pending[frameIndex] = std::move(frame);
+	while (!pending.empty() && pending.begin()->first == nextFrame)
+	{
+		writePending(pending.begin()->second);
+		pending.erase(pending.begin());
+		nextFrame++;
+	}
+	return true;
+}
+
+void OrderedStreamSink::writePending(PendingFrame &frame)
+{
+	// A duplicate always follows the frame it repeats, which is the last one written
+	if (!frame.duplicate)
+	{
+		spareBuffers.push_back(std::move(lastFrame));
+		lastFrame = std::move(frame.bytes);
+	}
+	std::fwrite(lastFrame.data(), 1, lastFrame.size(), stream);
+}
+
+void OrderedStreamSink::finish()
+{
+	std::lock_guard<std::mutex> lock(writeMutex);
+	if (!stream)
+		return;
+	// Frames after a gap (a failed readback) are still written, in order
+	for (auto &entry : pending)
+		writePending(entry.second);
+	pending.clear();
+	if (isPipe)
+		pclose(stream);
+	else
+		std::fclose(stream);
+	stream = nullptr;
+}
+
+std::string Y4mStreamSink::streamHeader(int width, int height) const
+{
+	char header[128];
+	std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%ld:1000 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+	              width, height, static_cast<long>(fps * 1000.0 + 0.5));
+	return header;
+}
+
+void Y4mStreamSink::encode(const Frame &frame, std::vector<unsigned char> &bytes) const
+{
+	static const char marker[] = "FRAME\n";
+	const size_t markerSize = sizeof(marker) - 1;
+	size_t lumaSize = static_cast<size_t>(frame.width) * frame.height;
+	size_t chromaSize = static_cast<size_t>((frame.width + 1) / 2) * ((frame.height + 1) / 2);
+	bytes.resize(markerSize + lumaSize + chromaSize * 2);
+	std::memcpy(bytes.data(), marker, markerSize);
+	unsigned char *y = bytes.data() + markerSize;
+	convertRgbaToI420(frame, y, y + lumaSize, y + lumaSize + chromaSize);
+}
+
+void RawRgbStreamSink::encode(const Frame &frame, std::vector<unsigned char> &bytes) const
+{
+	bytes.resize(static_cast<size_t>(frame.width) * frame.height * 3);
+	packRgbRows(frame, bytes.data(), false);
+}
+
+bool isStreamExportPath(const std::string &path)
+{
+	auto endsWith = [&](const char *suffix) {
+		size_t length = std::strlen(suffix);
+		return path.size() >= length && path.compare(path.size() - length, length, suffix) == 0;
+	};
+	return (!path.empty() && path[0] == '|') || path.rfind("rgb|", 0) == 0 || endsWith(".y4m") || endsWith(".rgb");
+}
@@ -0,0 +1,111 @@
+#ifndef FRAME_ENCODERS_H
+#define FRAME_ENCODERS_H
+
+#include "FrameExporter.h"
+
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ImageFormat { Ppm, Qoi, Png };
+
+// Writes one image file per frame. `pattern` is a printf pattern taking the
+// frame index, e.g. "out/frame_%06ld.png". Every worker encodes its own frame.
+// Duplicate frames become symlinks to the file of their source frame.
+class ImageSequenceSink : public FrameSink
+{
+public:
+	ImageSequenceSink(const std::string &pattern, ImageFormat format);
+	bool writeFrame(Frame &frame) override;
+	bool writeDuplicate(long frameIndex, long sourceIndex) override;
+
+private:
+	std::string framePath(long frameIndex) const;
+
+	std::string pattern;
+	ImageFormat format;
+};
+
+// Base for sinks that produce a single stream. Frames are converted on the
+// worker that received them; the converted bytes are then written strictly in
+// frame order, whichever worker finishes first. The formats have no way to
+// reference an earlier frame, so a duplicate rewrites the last frame's bytes
+// without converting anything.
+class OrderedStreamSink : public FrameSink
+{
+public:
+	~OrderedStreamSink() override;
+	void begin(int width, int height, long firstFrame) override;
+	bool writeFrame(Frame &frame) override;
+	bool writeDuplicate(long frameIndex, long sourceIndex) override;
+	void finish() override;
+
+protected:
+	// `target` is a file path, or a shell command prefixed with '|' that
+	// receives the stream on its standard input.
+	explicit OrderedStreamSink(const std::string &target);
+	virtual std::string streamHeader(int width, int height) const { return std::string(); }
+	virtual void encode(const Frame &frame, std::vector<unsigned char> &bytes) const = 0;
+
+private:
+	struct PendingFrame
+	{
+		std::vector<unsigned char> bytes;
+		bool duplicate = false;
+	};
+
+	bool queueFrame(long frameIndex, PendingFrame &&frame);
+	void writePending(PendingFrame &frame);
+
+	std::string target;
+	FILE *stream = nullptr;
+	bool isPipe = false;
+
+	std::mutex writeMutex;
+	long nextFrame = 0;
+	std::map<long, PendingFrame> pending;
+	std::vector<unsigned char> lastFrame;
+	std::vector<std::vector<unsigned char>> spareBuffers;
+};
+
+// YUV4MPEG2 stream, 4:2:0 BT.709 limited range. Every video encoder reads it:
+//   --export "|ffmpeg -y -i - out.mp4"   or   --export out.y4m
+class Y4mStreamSink : public OrderedStreamSink
+{
+public:
+	Y4mStreamSink(const std::string &target, double fps) : OrderedStreamSink(target), fps(fps) {}
+
+protected:
+	std::string streamHeader(int width, int height) const override;
+	void encode(const Frame &frame, std::vector<unsigned char> &bytes) const override;
+
+private:
+	double fps;
+};
+
+// Headerless packed RGB24, top-down rows:
+//   --export "rgb|ffmpeg -f rawvideo -pix_fmt rgb24 -s 1920x1080 -r 60 -i - out.mp4"
+class RawRgbStreamSink : public OrderedStreamSink
+{
+public:
+	explicit RawRgbStreamSink(const std::string &target) : OrderedStreamSink(target) {}
+
+protected:
+	void encode(const Frame &frame, std::vector<unsigned char> &bytes) const override;
+};
+
+// Converts a bottom-up RGBA frame into top-down I420 planes (y: width x height,
+// u and v: (width + 1) / 2 x (height + 1) / 2). Uses SSE2 where available.
+void convertRgbaToI420(const Frame &frame, unsigned char *y, unsigned char *u, unsigned char *v);
+
+void encodeQoi(const Frame &frame, std::vector<unsigned char> &bytes);
+// Fixed-Huffman deflate with a greedy single-probe matcher: fast, and flat
+// animation frames still compress well.
+void encodePng(const Frame &frame, std::vector<unsigned char> &bytes);
+
+// True if `path` names one of the stream formats above rather than an image sequence.
+bool isStreamExportPath(const std::string &path);
+
+#endif
@@ -0,0 +1,336 @@
+#include "FrameExporter.h"
+#include "FrameEncoders.h"
+#include "AllocationTracker.h"
+#include "GlResourceTracker.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+	// xxHash64-style: four independent lanes over 8-byte words, so it runs
+	// near memory bandwidth on the worker threads.
+	uint64_t hashPixels(const std::vector<unsigned char> &pixels)
+	{
+		const uint64_t PRIME1 = 0x9e3779b185ebca87ull, PRIME2 = 0xc2b2ae3d27d4eb4full;
+		auto rotate = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+		auto round = [&](uint64_t accumulator, uint64_t input) {
+			return rotate(accumulator + input * PRIME2, 31) * PRIME1;
+		};
+
+		const unsigned char *data = pixels.data();
+		size_t size = pixels.size();
+		uint64_t lanes[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+		size_t i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				uint64_t word;
+				std::memcpy(&word, data + i + lane * 8, 8);
+				lanes[lane] = round(lanes[lane], word);
+			}
+		}
+		uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+		for (; i < size; i++)
+			hash = rotate(hash ^ (data[i] * PRIME1), 11) * PRIME2;
+		hash ^= size;
+		hash ^= hash >> 33;
+		hash *= PRIME2;
+		hash ^= hash >> 29;
+		return hash;
+	}
+}
+
+std::unique_ptr<FrameSink> createFrameSink(const std::string &path, double fps)
+{
+	if (path.rfind("rgb|", 0) == 0)
+		return std::make_unique<RawRgbStreamSink>(path.substr(3));
+	if (!path.empty() && path[0] == '|')
+		return std::make_unique<Y4mStreamSink>(path, fps);
+
+	std::string extension = std::filesystem::path(path).extension().string();
+	if (extension == ".y4m")
+		return std::make_unique<Y4mStreamSink>(path, fps);
+	if (extension == ".rgb")
+		return std::make_unique<RawRgbStreamSink>(path);
+	if (path.find('%') != std::string::npos)
+	{
+		ImageFormat format = extension == ".png" ? ImageFormat::Png
+		                   : extension == ".qoi" ? ImageFormat::Qoi : ImageFormat::Ppm;
+		return std::make_unique<ImageSequenceSink>(path, format);
+	}
+	return std::make_unique<ImageSequenceSink>(path + "/frame_%06ld.ppm", ImageFormat::Ppm);
+}
+
+FrameExporter::~FrameExporter()
+{
+	finish();
+}
+
+bool FrameExporter::start(int frameWidth, int frameHeight, long firstFrame, std::unique_ptr<FrameSink> frameSink,
+                          unsigned int ringSize, unsigned int workerCount)
+{
+	finish();
+	if (!frameSink)
+		return false;
+
+	width = frameWidth;
+	height = frameHeight;
+	sink = std::move(frameSink);
+	sink->begin(width, height, firstFrame);
+	stopping = false;
+
+	GLsizeiptr frameBytes = static_cast<GLsizeiptr>(width) * height * 4;
+	slots.assign(ringSize > 0 ? std::max(2u, ringSize) : 0, Slot());
+	GL_RESOURCE_SITE("FrameExporter readback");
+	for (Slot &slot : slots)
+	{
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, NULL, GL_STREAM_READ);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	nextSlot = 0;
+
+	// Enough buffers for the ring, one per worker and two queued
+	workerCount = std::max(1u, workerCount);
+	poolSize = static_cast<unsigned int>(slots.size()) + workerCount + 2;
+	buffersInFlight = 0;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.emplace_back(&FrameExporter::workerLoop, this);
+	return true;
+}
+
+void FrameExporter::capture(GLuint framebuffer, long frameIndex)
+{
+	if (!sink || slots.empty())
+		return;
+	PROFILE_SCOPE("FrameExporter::capture");
+
+	// The slot about to be reused holds the oldest readback; hand it off first.
+	Slot &slot = slots[nextSlot];
+	collect(slot);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	if (framebuffer == 0)
+		glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frameIndex = frameIndex;
+	nextSlot = (nextSlot + 1) % slots.size();
+}
+
+void FrameExporter::repeat(long frameIndex)
+{
+	if (!sink)
+		return;
+
+	Frame frame;
+	frame.index = frameIndex;
+	frame.width = width;
+	frame.height = height;
+	frame.repeatsPrevious = true;
+	if (slots.empty())
+	{
+		submit(std::move(frame));
+		return;
+	}
+
+	// Goes through the ring like a readback so frames reach the workers in order
+	Slot &slot = slots[nextSlot];
+	collect(slot);
+	slot.frameIndex = frameIndex;
+	slot.repeat = true;
+	nextSlot = (nextSlot + 1) % slots.size();
+}
+
+void FrameExporter::collect(Slot &slot)
+{
+	if (slot.frameIndex < 0)
+		return;
+
+	if (slot.repeat)
+	{
+		Frame frame;
+		frame.index = slot.frameIndex;
+		frame.width = width;
+		frame.height = height;
+		frame.repeatsPrevious = true;
+		slot.frameIndex = -1;
+		slot.repeat = false;
+		submit(std::move(frame));
+		return;
+	}
+
+	// Only blocks if the transfer issued ringSize - 1 frames ago is still running
+	glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	Frame frame = acquireFrame(slot.frameIndex);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.pixels.size(), GL_MAP_READ_BIT);
+	if (mapped)
+	{
+		std::memcpy(frame.pixels.data(), mapped, frame.pixels.size());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.frameIndex = -1;
+
+	if (!mapped)
+	{
+		std::cout << "ERROR::EXPORT: Failed to map pixel buffer for frame " << frame.index << std::endl;
+		releaseBuffer(std::move(frame.pixels));
+		return;
+	}
+
+	submit(std::move(frame));
+}
+
+Frame FrameExporter::acquireFrame(long frameIndex)
+{
+	Frame frame;
+	frame.index = frameIndex;
+	frame.width = width;
+	frame.height = height;
+	{
+		std::unique_lock<std::mutex> lock(poolMutex);
+		poolCondition.wait(lock, [this]() { return !freeBuffers.empty() || buffersInFlight < poolSize; });
+		if (!freeBuffers.empty())
+		{
+			frame.pixels = std::move(freeBuffers.back());
+			freeBuffers.pop_back();
+		}
+		buffersInFlight++;
+	}
+	frame.pixels.resize(static_cast<size_t>(width) * height * 4);
+	return frame;
+}
+
+void FrameExporter::releaseBuffer(std::vector<unsigned char> &&buffer)
+{
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		freeBuffers.push_back(std::move(buffer));
+		buffersInFlight--;
+	}
+	poolCondition.notify_one();
+}
+
+void FrameExporter::submit(Frame &&frame)
+{
+	if (!sink)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		// Dropped here rather than by a worker: the next frame waits for the
+		// history entry of whatever frame was submitted before it
+		if (frame.repeatsPrevious && lastSubmitted < 0)
+		{
+			std::cout << "ERROR::EXPORT: Frame " << frame.index << " repeats a frame that was never exported" << std::endl;
+			return;
+		}
+		frame.previousIndex = lastSubmitted;
+		lastSubmitted = frame.index;
+		queue.push_back(std::move(frame));
+	}
+	queueCondition.notify_one();
+}
+
+long FrameExporter::findSource(const Frame &frame, uint64_t hash)
+{
+	// Frames leave the queue in order, so the previous one is at most a few
+	// hashes behind and this wait is short.
+	std::unique_lock<std::mutex> lock(historyMutex);
+	long source = frame.index;
+	if (frame.previousIndex >= 0)
+	{
+		historyCondition.wait(lock, [&]() { return history.count(frame.previousIndex) > 0; });
+		FrameRecord previous = history[frame.previousIndex];
+		history.erase(frame.previousIndex);
+		if (frame.repeatsPrevious || previous.hash == hash)
+		{
+			hash = previous.hash;
+			source = previous.sourceIndex;
+		}
+	}
+	history[frame.index] = {hash, source};
+	lock.unlock();
+	historyCondition.notify_all();
+	return source;
+}
+
+void FrameExporter::workerLoop()
+{
+	PROFILE_THREAD_NAME("encoder");
+	ALLOC_THREAD_NAME("encoder");
+	while (true)
+	{
+		Frame frame;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+			frame = std::move(queue.front());
+			queue.pop_front();
+		}
+		uint64_t hash = frame.repeatsPrevious ? 0 : hashPixels(frame.pixels);
+		long source = findSource(frame, hash);
+		if (source == frame.index)
+		{
+			PROFILE_SCOPE("FrameSink::writeFrame");
+			sink->writeFrame(frame);
+		}
+		else
+		{
+			PROFILE_SCOPE("FrameSink::writeDuplicate");
+			sink->writeDuplicate(frame.index, source);
+			duplicatesWritten++;
+		}
+		framesWritten++;
+		if (!frame.repeatsPrevious)
+			releaseBuffer(std::move(frame.pixels));
+	}
+}
+
+void FrameExporter::finish()
+{
+	if (!sink)
+		return;
+
+	// Drain the ring in capture order
+	for (size_t i = 0; i < slots.size(); i++)
+		collect(slots[(nextSlot + i) % slots.size()]);
+	for (Slot &slot : slots)
+		glDeleteBuffers(1, &slot.pbo);
+	slots.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+	for (std::thread &worker : workers)
+		worker.join();
+	workers.clear();
+
+	sink->finish();
+	sink.reset();
+	freeBuffers.clear();
+	history.clear();
+	lastSubmitted = -1;
+
+	std::cout << "Exported " << framesWritten << " frames, " << duplicatesWritten << " as duplicates" << std::endl;
+	framesWritten = 0;
+	duplicatesWritten = 0;
+}
@@ -0,0 +1,137 @@
+#ifndef FRAME_EXPORTER_H
+#define FRAME_EXPORTER_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One captured frame, RGBA8 with rows stored bottom-up as GL returns them.
+struct Frame
+{
+	long index = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+
+	// Set by the exporter. A repeated frame is one the scene declared identical
+	// to the previous frame; it carries no pixels.
+	bool repeatsPrevious = false;
+	long previousIndex = -1;
+};
+
+// Receives captured frames on the exporter's worker threads. writeFrame() is
+// called concurrently for different frames, in no particular order.
+class FrameSink
+{
+public:
+	virtual ~FrameSink() = default;
+	// Called once before the first frame, with the index of the first frame.
+	virtual void begin(int width, int height, long firstFrame) {}
+	virtual bool writeFrame(Frame &frame) = 0;
+	// Frame `frameIndex` is identical to frame `sourceIndex`, which was (or
+	// is being) passed to writeFrame(). Sinks store a reference instead of
+	// encoding the frame again.
+	virtual bool writeDuplicate(long frameIndex, long sourceIndex) = 0;
+	// Called once after the last frame has been written.
+	virtual void finish() {}
+};
+
+// Reads frames back without stalling the render loop. Each capture() starts
+// an asynchronous glReadPixels into the next pixel buffer object of a ring
+// and maps the PBO that was filled ringSize - 1 frames earlier, by which time
+// the transfer has normally completed. Mapped pixels are copied into a
+// buffer from a bounded pool and the frame is moved, not copied, to the
+// worker threads that pass it on to the sink; the buffer returns to the pool
+// once the sink is done. When every buffer is in flight the render thread
+// waits, so a slow sink holds back rendering instead of growing memory.
+//
+// Started with a ring size of 0 the exporter creates no GL objects and only
+// takes frames rendered on the CPU through submit().
+//
+// Workers hash every frame. A frame equal to the one before it, or one
+// queued with repeat(), reaches the sink as a duplicate of the first frame of
+// its run instead of being encoded again.
+class FrameExporter
+{
+public:
+	~FrameExporter();
+
+	bool start(int width, int height, long firstFrame, std::unique_ptr<FrameSink> sink,
+	           unsigned int ringSize = 3, unsigned int workerCount = 2);
+	// Queues a readback of `framebuffer` for frame `frameIndex`.
+	void capture(GLuint framebuffer, long frameIndex);
+	// A frame whose pixels come from the pool, to be filled and passed to submit().
+	Frame acquireFrame(long frameIndex);
+	// Queues a frame that is already in memory. Its pixels must come from acquireFrame().
+	void submit(Frame &&frame);
+	// Frame `frameIndex` is identical to the previously queued frame; nothing is read back.
+	void repeat(long frameIndex);
+	// Collects the frames still in flight, waits for the workers and closes the sink.
+	void finish();
+
+	bool isActive() const { return sink != nullptr; }
+
+private:
+	struct Slot
+	{
+		GLuint pbo = 0;
+		GLsync fence = 0;
+		long frameIndex = -1;
+		bool repeat = false;
+	};
+
+	struct FrameRecord
+	{
+		uint64_t hash;
+		long sourceIndex;
+	};
+
+	void collect(Slot &slot);
+	void workerLoop();
+	void releaseBuffer(std::vector<unsigned char> &&buffer);
+	long findSource(const Frame &frame, uint64_t hash);
+
+	int width = 0;
+	int height = 0;
+	std::vector<Slot> slots;
+	unsigned int nextSlot = 0;
+
+	std::unique_ptr<FrameSink> sink;
+	std::vector<std::thread> workers;
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::deque<Frame> queue;
+	bool stopping = false;
+
+	std::mutex poolMutex;
+	std::condition_variable poolCondition;
+	std::vector<std::vector<unsigned char>> freeBuffers;
+	unsigned int buffersInFlight = 0;
+	unsigned int poolSize = 0;
+
+	long lastSubmitted = -1;
+	std::mutex historyMutex;
+	std::condition_variable historyCondition;
+	std::map<long, FrameRecord> history;
+	std::atomic<long> framesWritten {0};
+	std::atomic<long> duplicatesWritten {0};
+};
+
+// Builds the sink for an --export path:
+//   <dir>                 PPM sequence, <dir>/frame_000000.ppm ...
+//   <dir>/name_%06ld.png  image sequence, format from the extension (.ppm, .qoi, .png)
+//   out.y4m, out.rgb      one Y4M or raw RGB24 stream file
+//   |<command>            Y4M stream piped into <command>
+//   rgb|<command>         raw RGB24 stream piped into <command>
+std::unique_ptr<FrameSink> createFrameSink(const std::string &path, double fps);
+
+#endif
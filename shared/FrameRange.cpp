@@ -0,0 +1,167 @@
+#include "FrameRange.h"
+#include "FrameEncoders.h"
+#include "RenderContext.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	// Options the coordinator rewrites for each worker
+	bool isShardOption(const std::string &arg)
+	{
+		return arg == "--workers" || arg == "--range" || arg == "--frames" || arg == "--fps" || arg == "--export" || arg == "--profile" || arg == "--frame-stats" || arg == "--threads";
+	}
+
+	// out.y4m -> out.part3.y4m
+	std::string partPath(const std::string &path, long shard)
+	{
+		std::filesystem::path p(path);
+		std::filesystem::path name = p.stem().string() + ".part" + std::to_string(shard) + p.extension().string();
+		return (p.parent_path() / name).string();
+	}
+
+	// Joins the shard streams into `path`. Every Y4M part starts with its own
+	// stream header; only the first one is kept.
+	bool mergeStreamParts(const std::string &path, long shardCount)
+	{
+		bool isY4m = std::filesystem::path(path).extension() == ".y4m";
+		FILE *output = std::fopen(path.c_str(), "wb");
+		if (!output)
+		{
+			std::cout << "ERROR::RENDER: Failed to open " << path << std::endl;
+			return false;
+		}
+
+		bool ok = true;
+		std::vector<char> buffer(1 << 20);
+		for (long shard = 0; shard < shardCount && ok; shard++)
+		{
+			std::string part = partPath(path, shard);
+			FILE *input = std::fopen(part.c_str(), "rb");
+			if (!input)
+			{
+				std::cout << "ERROR::RENDER: Missing stream part " << part << std::endl;
+				ok = false;
+				break;
+			}
+			if (isY4m && shard > 0)
+			{
+				int c;
+				while ((c = std::fgetc(input)) != EOF && c != '\n') {}
+			}
+			size_t read;
+			while ((read = std::fread(buffer.data(), 1, buffer.size(), input)) > 0)
+				std::fwrite(buffer.data(), 1, read, output);
+			std::fclose(input);
+			std::filesystem::remove(part);
+		}
+		return std::fclose(output) == 0 && ok;
+	}
+}
+
+int runFrameRangeWorkers(int argc, char const *argv[], const RenderOptions &options)
+{
+	if (options.frames <= 0)
+	{
+		std::cout << "ERROR::RENDER: --workers needs a frame count (--range or --frames)" << std::endl;
+		return 1;
+	}
+
+	// Image sequences are numbered by frame and can share a directory; a single
+	// stream is written as one part per shard and joined at the end.
+	bool splitStream = isStreamExportPath(options.exportPath);
+	if (splitStream && options.exportPath.find('|') != std::string::npos)
+	{
+		std::cout << "ERROR::RENDER: A piped export cannot be split across workers, export to a .y4m or .rgb file" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> baseArgs;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (isShardOption(arg))
+			i++;
+		else if (arg != "--headless")
+			baseArgs.push_back(arg);
+	}
+
+	double fps = options.fps > 0.0 ? options.fps : 60.0;
+	long workerCount = std::min<long>(options.workers, options.frames);
+	long first = options.startFrame;
+	long end = options.startFrame + options.frames;
+	// Every worker runs its own job system and encoders, so they share the cores
+	unsigned int threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+	long workerThreads = std::max<long>(1, threads / workerCount);
+
+	std::vector<pid_t> children;
+	for (long shard = 0; shard < workerCount; shard++)
+	{
+		long shardBegin = first + (end - first) * shard / workerCount;
+		long shardEnd = first + (end - first) * (shard + 1) / workerCount;
+
+		std::vector<std::string> args = {argv[0], "--headless",
+			"--range", std::to_string(shardBegin) + ":" + std::to_string(shardEnd),
+			"--fps", std::to_string(fps), "--threads", std::to_string(workerThreads)};
+		if (!options.exportPath.empty())
+		{
+			args.push_back("--export");
+			args.push_back(splitStream ? partPath(options.exportPath, shard) : options.exportPath);
+		}
+		if (!options.profilePath.empty())
+		{
+			args.push_back("--profile");
+			args.push_back(partPath(options.profilePath, shard));
+		}
+		if (!options.frameStatsPath.empty())
+		{
+			args.push_back("--frame-stats");
+			args.push_back(partPath(options.frameStatsPath, shard));
+		}
+		args.insert(args.end(), baseArgs.begin(), baseArgs.end());
+
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			std::vector<char*> childArgv;
+			for (std::string &arg : args)
+				childArgv.push_back(&arg[0]);
+			childArgv.push_back(nullptr);
+			execv("/proc/self/exe", childArgv.data());
+			std::cout << "ERROR::RENDER: Failed to start worker " << shard << std::endl;
+			_exit(127);
+		}
+		if (pid < 0)
+		{
+			std::cout << "ERROR::RENDER: fork failed for worker " << shard << std::endl;
+			break;
+		}
+		children.push_back(pid);
+	}
+
+	int failures = static_cast<int>(workerCount - children.size());
+	for (pid_t child : children)
+	{
+		int status = 0;
+		waitpid(child, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			failures++;
+	}
+
+	if (splitStream && failures == 0 && !mergeStreamParts(options.exportPath, workerCount))
+		failures++;
+
+	std::cout << "Rendered frames " << first << "-" << end - 1 << " with " << workerCount << " workers";
+	if (failures)
+		std::cout << ", " << failures << " failed";
+	std::cout << std::endl;
+	return failures ? 1 : 0;
+}
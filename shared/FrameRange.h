@@ -0,0 +1,16 @@
+#ifndef FRAME_RANGE_H
+#define FRAME_RANGE_H
+
+struct RenderOptions;
+
+// Splits [startFrame, startFrame + frames) into `workers` contiguous shards
+// and renders each one in a headless child process of the same executable,
+// started with --range for its shard and the same fps so every worker seeks
+// straight to its first frame. Exported frames are numbered by their absolute
+// index, so the shards land in order in the export directory; a .y4m or .rgb
+// stream export is rendered as one part per worker and joined afterwards.
+// The --threads budget (default: all cores) is divided between the workers.
+// Returns the process exit status: 0 if every worker succeeded.
+int runFrameRangeWorkers(int argc, char const *argv[], const RenderOptions &options);
+
+#endif
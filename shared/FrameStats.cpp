@@ -0,0 +1,164 @@
+#include "FrameStats.h"
+#include "GlCallCounter.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+	void writeArray(std::ofstream &out, const char *name, const std::vector<float> &values)
+	{
+		out << ",\n  \"" << name << "\": [";
+		for (size_t i = 0; i < values.size(); i++)
+			out << (i == 0 ? "" : ", ") << values[i];
+		out << "]";
+	}
+}
+
+void FrameStats::start(double createTime, bool gpu)
+{
+	active = true;
+	this->gpu = gpu;
+	this->createTime = createTime;
+	beginFrame();
+}
+
+void FrameStats::beginFrame()
+{
+	if (!gpu)
+		return;
+	frameStartQuery = acquireQuery();
+	glQueryCounter(frameStartQuery, GL_TIMESTAMP);
+}
+
+void FrameStats::endFrame(double cpuTimeMs, double now)
+{
+	if (startupMs < 0.0)
+		startupMs = (now - createTime) * 1000.0;
+	frameMs.push_back(static_cast<float>((now - (lastPresent > 0.0 ? lastPresent : createTime)) * 1000.0));
+	cpuMs.push_back(static_cast<float>(cpuTimeMs));
+	lastPresent = now;
+
+	if (!gpu)
+		return;
+	GLuint endQuery = acquireQuery();
+	glQueryCounter(endQuery, GL_TIMESTAMP);
+	pending.push_back({ gpuMs.size(), { frameStartQuery, endQuery } });
+	frameStartQuery = 0;
+	// Filled in once the timestamps are read back
+	gpuMs.push_back(-1.0f);
+	collect(false);
+}
+
+GLuint FrameStats::acquireQuery()
+{
+	if (freeQueries.empty())
+	{
+		GL_RESOURCE_SITE("FrameStats");
+		freeQueries.resize(8);
+		glGenQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+	}
+	GLuint query = freeQueries.back();
+	freeQueries.pop_back();
+	return query;
+}
+
+void FrameStats::collect(bool wait)
+{
+	// Frames finish in order, stop at the first one that has not
+	size_t done = 0;
+	for (; done < pending.size(); done++)
+	{
+		PendingFrame &frame = pending[done];
+		if (!wait)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+		}
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[1], GL_QUERY_RESULT, &end);
+		gpuMs[frame.index] = static_cast<float>((end - begin) / 1e6);
+		freeQueries.push_back(frame.queries[0]);
+		freeQueries.push_back(frame.queries[1]);
+	}
+	pending.erase(pending.begin(), pending.begin() + done);
+}
+
+bool FrameStats::finish(const std::string &path)
+{
+	if (!active)
+		return false;
+	active = false;
+	if (gpu)
+	{
+		collect(true);
+		if (frameStartQuery)
+			freeQueries.push_back(frameStartQuery);
+		if (!freeQueries.empty())
+			glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+		freeQueries.clear();
+		frameStartQuery = 0;
+	}
+
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "ERROR::FRAME_STATS: Failed to open " << path << std::endl;
+		return false;
+	}
+	double rssMb = 0.0, peakRssMb = 0.0;
+	readMemoryUsage(rssMb, peakRssMb);
+	out << std::fixed << std::setprecision(4);
+	out << "{\n  \"frames\": " << frameMs.size()
+	    << ",\n  \"startup_ms\": " << startupMs
+	    << ",\n  \"peak_rss_mb\": " << peakRssMb;
+	if (isGlCallCounterInstalled())
+	{
+		const GlCallStats &run = glRunStats();
+		out << ",\n  \"gl_objects_created\": " << run.objectsCreated
+		    << ",\n  \"gl_objects_deleted\": " << run.objectsDeleted
+		    << ",\n  \"gl_draw_calls\": " << run.drawCalls;
+	}
+	if (gpu)
+	{
+		const ProgramCacheStats &programs = programCacheStats();
+		out << ",\n  \"programs_cached\": " << programs.hits
+		    << ",\n  \"programs_compiled\": " << programs.misses + programs.rejected + programs.uncached
+		    << ",\n  \"program_load_ms\": " << programs.loadMs;
+	}
+	writeArray(out, "frame_ms", frameMs);
+	writeArray(out, "cpu_ms", cpuMs);
+	if (gpu)
+		writeArray(out, "gpu_ms", gpuMs);
+	out << "\n}\n";
+
+	if (!out)
+	{
+		std::cout << "ERROR::FRAME_STATS: Failed to write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool readMemoryUsage(double &rssMb, double &peakRssMb)
+{
+	rssMb = peakRssMb = 0.0;
+	std::ifstream status("/proc/self/status");
+	if (!status)
+		return false;
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmRSS:") == 0)
+			rssMb = std::atof(line.c_str() + 6) / 1024.0;
+		else if (line.compare(0, 6, "VmHWM:") == 0)
+			peakRssMb = std::atof(line.c_str() + 6) / 1024.0;
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+// Per-frame timings of one run, written as JSON with --frame-stats <file>
+// for the SceneBench runner:
+//
+//   frame_ms   wall time between presents
+//   cpu_ms     time the scene spent on the frame before presenting
+//   gpu_ms     GPU time between GL timestamps at the start of the frame and
+//              after presenting it (absent in --software runs)
+//
+// along with the startup time (RenderContext::create to the end of the first
+// frame), the peak resident set size and, in GL runs, the GL objects the
+// call counter saw being created and deleted and how many programs came from
+// the program cache and how long loading them took. Timestamp queries are read back
+// a few frames late, once available, so they never stall the pipeline.
+class FrameStats
+{
+public:
+	// `gpu` needs a current GL context
+	void start(double createTime, bool gpu);
+	bool isActive() const { return active; }
+
+	// Called by swapBuffers: endFrame once the frame is presented, `now` in
+	// seconds on the steady clock, then beginFrame for the next one.
+	void beginFrame();
+	void endFrame(double cpuTimeMs, double now);
+
+	// Waits for the outstanding queries and writes the report. Needs the GL
+	// context of a GPU run to still be current.
+	bool finish(const std::string &path);
+
+private:
+	struct PendingFrame
+	{
+		size_t index;
+		GLuint queries[2];
+	};
+
+	GLuint acquireQuery();
+	void collect(bool wait);
+
+	bool active = false;
+	bool gpu = false;
+	double createTime = 0.0;
+	double startupMs = -1.0;
+	double lastPresent = 0.0;
+	std::vector<float> frameMs, cpuMs, gpuMs;
+	std::vector<PendingFrame> pending;
+	std::vector<GLuint> freeQueries;
+	GLuint frameStartQuery = 0;
+};
+
+// Resident and peak resident set size of this process in MB, from /proc.
+bool readMemoryUsage(double &rssMb, double &peakRssMb);
+
+#endif
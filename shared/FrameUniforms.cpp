@@ -0,0 +1,65 @@
+#include "FrameUniforms.h"
+#include "GlResourceTracker.h"
+
+#include <cstddef>
+
+#include <glm/glm/gtc/matrix_transform.hpp>
+
+static_assert(offsetof(FrameUniforms, projection) == 0 && offsetof(FrameUniforms, viewport) == 64
+              && offsetof(FrameUniforms, time) == 72 && offsetof(FrameUniforms, frame) == 76
+              && sizeof(FrameUniforms) == 80, "FrameUniforms must match the std140 layout of the block");
+
+const char *const FRAME_UNIFORMS_GLSL = R"(layout (std140) uniform FrameUniforms {
+	mat4 projection;
+	vec2 viewport;
+	float time;
+	int frame;
+};
+)";
+
+void bindFrameUniformBlock(GLuint program)
+{
+	GLuint index = glGetUniformBlockIndex(program, "FrameUniforms");
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, index, FRAME_UNIFORMS_BINDING);
+}
+
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+	release();
+}
+
+void FrameUniformBuffer::create()
+{
+	release();
+	GL_RESOURCE_SITE("FrameUniformBuffer");
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniformBuffer::update(int width, int height, double time, long frame)
+{
+	if (!buffer)
+		return;
+	if (uniforms.viewport.x != width || uniforms.viewport.y != height)
+	{
+		uniforms.projection = glm::ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height));
+		uniforms.viewport = glm::vec2(width, height);
+	}
+	uniforms.time = static_cast<float>(time);
+	uniforms.frame = static_cast<GLint>(frame);
+
+	// Binding the base again also covers code that used the binding point in between
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms);
+}
+
+void FrameUniformBuffer::release()
+{
+	if (buffer)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	uniforms = FrameUniforms();
+}
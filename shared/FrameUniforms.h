@@ -0,0 +1,55 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm/glm.hpp>
+
+// Values every program may read, uploaded once per frame by RenderContext
+// into a uniform buffer at FRAME_UNIFORMS_BINDING. A program declares the
+// block by passing FRAME_UNIFORMS_GLSL in the defines of loadProgram(), which
+// points the block at the binding after linking, so draws set nothing.
+//
+// Mirrors the std140 layout of the GLSL block: projection at 0, viewport at
+// 64, time at 72 and frame at 76.
+struct FrameUniforms
+{
+	glm::mat4 projection = glm::mat4(1.0f); // framebuffer pixels, origin bottom left, to clip space
+	glm::vec2 viewport = glm::vec2(0.0f);   // framebuffer size in pixels
+	float time = 0.0f;                      // RenderContext::time()
+	GLint frame = 0;                        // RenderContext::frameIndex()
+};
+
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// The block declaration, for the defines of loadProgram() or ShaderLibrary::load()
+extern const char *const FRAME_UNIFORMS_GLSL;
+
+// Points the FrameUniforms block of `program`, if it has one, at FRAME_UNIFORMS_BINDING
+void bindFrameUniformBlock(GLuint program);
+
+// The buffer behind the block, owned by RenderContext.
+class FrameUniformBuffer
+{
+public:
+	FrameUniformBuffer() = default;
+	~FrameUniformBuffer();
+
+	FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+	FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+	void create();
+	// Uploads the values of the frame about to be drawn and binds the buffer
+	// at FRAME_UNIFORMS_BINDING.
+	void update(int width, int height, double time, long frame);
+	// Needs the GL context to still be current
+	void release();
+
+	const FrameUniforms &values() const { return uniforms; }
+
+private:
+	GLuint buffer = 0;
+	FrameUniforms uniforms;
+};
+
+#endif
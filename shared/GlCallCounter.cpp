@@ -0,0 +1,189 @@
+#include <glad/glad.h>
+
+#include "GlCallCounter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace {
+	enum class GlCallCategory { Draw, Upload, Read, ProgramBind, Bind, Create, Delete, State, Other };
+
+	GlCallStats current, lastFrame, totals;
+	// Everything after the first frame, which also holds the scene's setup
+	GlCallStats steady;
+	long frames = 0;
+	bool installed = false;
+
+	uint64_t pixelBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+	{
+		uint64_t components = 4;
+		switch (format)
+		{
+		case GL_RED: case GL_DEPTH_COMPONENT: case GL_RED_INTEGER: components = 1; break;
+		case GL_RG: components = 2; break;
+		case GL_RGB: case GL_BGR: components = 3; break;
+		default: break;
+		}
+		uint64_t componentSize = 1;
+		switch (type)
+		{
+		case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: componentSize = 2; break;
+		case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: componentSize = 4; break;
+		default: break;
+		}
+		return static_cast<uint64_t>(std::max(width, 0)) * static_cast<uint64_t>(std::max(height, 0)) * components * componentSize;
+	}
+
+	void countCall(GlCallCategory category, uint64_t amount)
+	{
+		switch (category)
+		{
+		case GlCallCategory::Draw: current.drawCalls++; break;
+		case GlCallCategory::Upload: current.uploadedBytes += amount; break;
+		case GlCallCategory::Read: current.readBytes += amount; break;
+		case GlCallCategory::ProgramBind: current.programBinds++; break;
+		case GlCallCategory::Bind: current.binds++; break;
+		case GlCallCategory::Create: current.objectsCreated += amount; break;
+		case GlCallCategory::Delete: current.objectsDeleted += amount; break;
+		case GlCallCategory::State: current.stateChanges++; break;
+		case GlCallCategory::Other: break;
+		}
+	}
+
+	const char *entryPointNames[] = {
+#define GL_ENTRY_POINT_NAME(returnType, name, params, args, category, amount) "gl" #name,
+		GL_COUNTED_ENTRY_POINTS(GL_ENTRY_POINT_NAME)
+#undef GL_ENTRY_POINT_NAME
+	};
+
+	const GlCallCategory entryPointCategories[] = {
+#define GL_ENTRY_POINT_CATEGORY(returnType, name, params, args, category, amount) GlCallCategory::category,
+		GL_COUNTED_ENTRY_POINTS(GL_ENTRY_POINT_CATEGORY)
+#undef GL_ENTRY_POINT_CATEGORY
+	};
+
+	// The original pointer of every entry point and a wrapper that counts the
+	// call before forwarding it.
+#define GL_ENTRY_POINT_WRAPPER(returnType, name, params, args, category, amount) \
+	decltype(glad_gl##name) real##name = nullptr; \
+	returnType APIENTRY counted##name params \
+	{ \
+		current.calls[static_cast<int>(GlEntryPoint::name)]++; \
+		current.totalCalls++; \
+		countCall(GlCallCategory::category, static_cast<uint64_t>(amount)); \
+		return real##name args; \
+	}
+	GL_COUNTED_ENTRY_POINTS(GL_ENTRY_POINT_WRAPPER)
+#undef GL_ENTRY_POINT_WRAPPER
+}
+
+void GlCallStats::add(const GlCallStats &other)
+{
+	for (int i = 0; i < static_cast<int>(GlEntryPoint::Count); i++)
+		calls[i] += other.calls[i];
+	totalCalls += other.totalCalls;
+	drawCalls += other.drawCalls;
+	uploadedBytes += other.uploadedBytes;
+	readBytes += other.readBytes;
+	programBinds += other.programBinds;
+	binds += other.binds;
+	objectsCreated += other.objectsCreated;
+	objectsDeleted += other.objectsDeleted;
+	stateChanges += other.stateChanges;
+}
+
+void installGlCallCounter()
+{
+	if (installed)
+		return;
+#define GL_ENTRY_POINT_INSTALL(returnType, name, params, args, category, amount) \
+	real##name = glad_gl##name; \
+	if (real##name) \
+		glad_gl##name = counted##name;
+	GL_COUNTED_ENTRY_POINTS(GL_ENTRY_POINT_INSTALL)
+#undef GL_ENTRY_POINT_INSTALL
+	installed = true;
+}
+
+void uninstallGlCallCounter()
+{
+	if (!installed)
+		return;
+#define GL_ENTRY_POINT_UNINSTALL(returnType, name, params, args, category, amount) \
+	if (real##name) \
+		glad_gl##name = real##name;
+	GL_COUNTED_ENTRY_POINTS(GL_ENTRY_POINT_UNINSTALL)
+#undef GL_ENTRY_POINT_UNINSTALL
+	installed = false;
+}
+
+bool isGlCallCounterInstalled()
+{
+	return installed;
+}
+
+void glCallCounterFrame()
+{
+	lastFrame = current;
+	totals.add(current);
+	if (frames > 0)
+		steady.add(current);
+	frames++;
+
+	PROFILE_COUNTER("GL calls", static_cast<double>(current.totalCalls));
+	PROFILE_COUNTER("GL draw calls", static_cast<double>(current.drawCalls));
+	PROFILE_COUNTER("GL uploaded bytes", static_cast<double>(current.uploadedBytes));
+	PROFILE_COUNTER("GL program binds", static_cast<double>(current.programBinds));
+	PROFILE_COUNTER("GL objects created", static_cast<double>(current.objectsCreated));
+	current = GlCallStats();
+}
+
+const GlCallStats &glLastFrameStats()
+{
+	return lastFrame;
+}
+
+const GlCallStats &glRunStats()
+{
+	return totals;
+}
+
+const char *glEntryPointName(GlEntryPoint entry)
+{
+	return entryPointNames[static_cast<int>(entry)];
+}
+
+void printGlCallReport()
+{
+	if (frames == 0)
+		return;
+
+	std::vector<int> used;
+	for (int i = 0; i < static_cast<int>(GlEntryPoint::Count); i++)
+		if (totals.calls[i] > 0)
+			used.push_back(i);
+	std::sort(used.begin(), used.end(), [](int a, int b) { return totals.calls[a] > totals.calls[b]; });
+
+	double perFrame = 1.0 / frames;
+	std::printf("GL calls per frame, averaged over %ld frames:\n", frames);
+	for (int i : used)
+		std::printf("  %-26s %12.1f\n", entryPointNames[i], totals.calls[i] * perFrame);
+	std::printf("  draw calls %.1f, uploaded %.1f KB, read back %.1f KB, program binds %.1f, objects created %.1f\n",
+	            totals.drawCalls * perFrame, totals.uploadedBytes * perFrame / 1024.0, totals.readBytes * perFrame / 1024.0,
+	            totals.programBinds * perFrame, totals.objectsCreated * perFrame);
+
+	// Setup belongs to the first frame; anything created after it, every frame, is almost always a leak
+	if (frames > 1 && steady.objectsCreated > 0)
+	{
+		double steadyPerFrame = 1.0 / (frames - 1);
+		std::cout << "WARNING::GL_STATS: " << steady.objectsCreated * steadyPerFrame
+		          << " GL objects created per frame after the first:";
+		for (int i = 0; i < static_cast<int>(GlEntryPoint::Count); i++)
+			if (entryPointCategories[i] == GlCallCategory::Create && steady.calls[i] > 0)
+				std::cout << " " << entryPointNames[i] << " (" << steady.calls[i] * steadyPerFrame << ")";
+		std::cout << std::endl;
+	}
+}
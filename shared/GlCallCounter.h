@@ -0,0 +1,120 @@
+#ifndef GL_CALL_COUNTER_H
+#define GL_CALL_COUNTER_H
+
+#include <cstdint>
+
+// Counts GL calls by swapping glad's function pointers (glad_glDrawArrays,
+// ...) for wrappers that count and then forward. Only the entry points in
+// GlCallCounter.cpp are wrapped: draws, uploads, readbacks, binds, object
+// creation and deletion, shader compiles, uniforms and common state changes.
+// While not installed nothing is wrapped and nothing costs anything.
+//
+// Enabled with --gl-stats (and with --profile, which adds the per-frame
+// numbers to the trace as counters). A report of the average calls per frame
+// is printed at exit, and objects that keep being created frame after frame
+// are flagged.
+
+// X(return type, name without the gl prefix, parameters, arguments, category,
+//   amount), where amount is what the call adds to its category: bytes for
+//   uploads and reads, the object count for creations and deletions.
+#define GL_COUNTED_ENTRY_POINTS(X) \
+	X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), Draw, 1) \
+	X(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices), Draw, 1) \
+	X(void, DrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount), (mode, first, count, instancecount), Draw, 1) \
+	X(void, DrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount), (mode, count, type, indices, instancecount), Draw, 1) \
+	X(void, DrawRangeElements, (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices), (mode, start, end, count, type, indices), Draw, 1) \
+	X(void, Clear, (GLbitfield mask), (mask), Other, 1) \
+	X(void, BlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter), Other, 1) \
+	X(void, BufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage), Upload, data ? size : 0) \
+	X(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), (target, offset, size, data), Upload, size) \
+	X(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels), Upload, pixels ? pixelBytes(width, height, format, type) : 0) \
+	X(void, TexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels), Upload, pixelBytes(width, height, format, type)) \
+	X(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), (x, y, width, height, format, type, pixels), Read, pixelBytes(width, height, format, type)) \
+	X(void *, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access), Other, 1) \
+	X(GLboolean, UnmapBuffer, (GLenum target), (target), Other, 1) \
+	X(void, UseProgram, (GLuint program), (program), ProgramBind, 1) \
+	X(void, BindBuffer, (GLenum target, GLuint buffer), (target, buffer), Bind, 1) \
+	X(void, BindVertexArray, (GLuint array), (array), Bind, 1) \
+	X(void, BindTexture, (GLenum target, GLuint texture), (target, texture), Bind, 1) \
+	X(void, BindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer), Bind, 1) \
+	X(void, BindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer), Bind, 1) \
+	X(GLuint, CreateProgram, (), (), Create, 1) \
+	X(GLuint, CreateShader, (GLenum type), (type), Create, 1) \
+	X(void, GenBuffers, (GLsizei n, GLuint *buffers), (n, buffers), Create, n) \
+	X(void, GenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays), Create, n) \
+	X(void, GenTextures, (GLsizei n, GLuint *textures), (n, textures), Create, n) \
+	X(void, GenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers), Create, n) \
+	X(void, GenRenderbuffers, (GLsizei n, GLuint *renderbuffers), (n, renderbuffers), Create, n) \
+	X(void, GenQueries, (GLsizei n, GLuint *ids), (n, ids), Create, n) \
+	X(void, DeleteProgram, (GLuint program), (program), Delete, 1) \
+	X(void, DeleteShader, (GLuint shader), (shader), Delete, 1) \
+	X(void, DeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers), Delete, n) \
+	X(void, DeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays), Delete, n) \
+	X(void, DeleteTextures, (GLsizei n, const GLuint *textures), (n, textures), Delete, n) \
+	X(void, DeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers), Delete, n) \
+	X(void, DeleteRenderbuffers, (GLsizei n, const GLuint *renderbuffers), (n, renderbuffers), Delete, n) \
+	X(void, DeleteQueries, (GLsizei n, const GLuint *ids), (n, ids), Delete, n) \
+	X(void, CompileShader, (GLuint shader), (shader), Other, 1) \
+	X(void, LinkProgram, (GLuint program), (program), Other, 1) \
+	X(GLint, GetUniformLocation, (GLuint program, const GLchar *name), (program, name), Other, 1) \
+	X(void, Uniform1i, (GLint location, GLint v0), (location, v0), Other, 1) \
+	X(void, Uniform1f, (GLint location, GLfloat v0), (location, v0), Other, 1) \
+	X(void, Uniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1), Other, 1) \
+	X(void, Uniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2), Other, 1) \
+	X(void, Uniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3), Other, 1) \
+	X(void, UniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value), Other, 1) \
+	X(void, GetIntegerv, (GLenum pname, GLint *data), (pname, data), Other, 1) \
+	X(void, Enable, (GLenum cap), (cap), State, 1) \
+	X(void, Disable, (GLenum cap), (cap), State, 1) \
+	X(void, BlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor), State, 1) \
+	X(void, BlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha), State, 1) \
+	X(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), State, 1) \
+	X(void, ClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha), State, 1) \
+	X(void, PixelStorei, (GLenum pname, GLint param), (pname, param), State, 1) \
+	X(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer), State, 1) \
+	X(void, EnableVertexAttribArray, (GLuint index), (index), State, 1) \
+	X(void, Flush, (), (), Other, 1) \
+	X(void, Finish, (), (), Other, 1)
+
+enum class GlEntryPoint : int
+{
+#define GL_ENTRY_POINT_ENUM(returnType, name, params, args, category, amount) name,
+	GL_COUNTED_ENTRY_POINTS(GL_ENTRY_POINT_ENUM)
+#undef GL_ENTRY_POINT_ENUM
+	Count
+};
+
+struct GlCallStats
+{
+	uint64_t calls[static_cast<int>(GlEntryPoint::Count)] = {};
+	uint64_t totalCalls = 0;
+	uint64_t drawCalls = 0;
+	uint64_t uploadedBytes = 0; // glBufferData, glBufferSubData, glTexImage2D, glTexSubImage2D
+	uint64_t readBytes = 0;     // glReadPixels
+	uint64_t programBinds = 0;
+	uint64_t binds = 0;         // buffers, vertex arrays, textures, framebuffers, renderbuffers
+	uint64_t objectsCreated = 0;
+	uint64_t objectsDeleted = 0;
+	uint64_t stateChanges = 0;
+
+	void add(const GlCallStats &other);
+};
+
+// Must be called after gladLoadGLLoader, with the context current.
+void installGlCallCounter();
+void uninstallGlCallCounter();
+bool isGlCallCounterInstalled();
+
+// Closes the current frame: its counts become glLastFrameStats() and are
+// added to the run totals.
+void glCallCounterFrame();
+const GlCallStats &glLastFrameStats();
+// Totals of every frame closed so far
+const GlCallStats &glRunStats();
+const char *glEntryPointName(GlEntryPoint entry);
+
+// Prints the average calls per frame of every entry point that was used and
+// warns about steady per-frame object creation.
+void printGlCallReport();
+
+#endif
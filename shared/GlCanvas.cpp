@@ -0,0 +1,212 @@
+#include "GlCanvas.h"
+#include "AllocationTracker.h"
+#include "FrameUniforms.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+#include "Profiler.h"
+
+namespace {
+	const char* geometryVertexShaderSource = R"(
+		#version 330 core
+		layout (location = 0) in vec3 aPos;
+		uniform float pointSize;
+		void main() {
+			gl_Position = vec4(aPos, 1.0);
+			gl_PointSize = pointSize;
+		}
+	)";
+
+	const char* geometryFragmentShaderSource = R"(
+		#version 330 core
+		out vec4 FragColor;
+		uniform vec4 color;
+		void main() {
+			FragColor = color;
+		}
+	)";
+
+	const char* textVertexShaderSource = R"(
+		#version 330 core
+		layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+		out vec2 TexCoords;
+		void main() {
+			gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+			TexCoords = vertex.zw;
+		}
+	)";
+
+	const char* textFragmentShaderSource = R"(
+		#version 330 core
+		in vec2 TexCoords;
+		out vec4 color;
+		uniform sampler2D text;
+		uniform vec3 textColor;
+		void main() {
+			color = vec4(textColor, texture(text, TexCoords).r);
+		}
+	)";
+}
+
+GlCanvas::GlCanvas(int width, int height) : canvasWidth(width), canvasHeight(height)
+{
+	GL_RESOURCE_SITE("GlCanvas");
+	geometryProgram = loadProgram("GlCanvas geometry", geometryVertexShaderSource, geometryFragmentShaderSource);
+	colorLocation = glGetUniformLocation(geometryProgram, "color");
+	pointSizeLocation = glGetUniformLocation(geometryProgram, "pointSize");
+
+	// Glyph quads are in framebuffer pixels, mapped by the per-frame projection
+	textProgram = loadProgram("GlCanvas text", textVertexShaderSource, textFragmentShaderSource, FRAME_UNIFORMS_GLSL);
+	textColorLocation = glGetUniformLocation(textProgram, "textColor");
+
+	glGenVertexArrays(1, &geometryVAO);
+	glGenBuffers(1, &geometryVBO);
+	glBindVertexArray(geometryVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, geometryVBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glGenVertexArrays(1, &textVAO);
+	glGenBuffers(1, &textVBO);
+	glBindVertexArray(textVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	glEnable(GL_MULTISAMPLE);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+}
+
+GlCanvas::~GlCanvas()
+{
+	glDeleteVertexArrays(1, &geometryVAO);
+	glDeleteBuffers(1, &geometryVBO);
+	glDeleteVertexArrays(1, &textVAO);
+	glDeleteBuffers(1, &textVBO);
+	glDeleteProgram(geometryProgram);
+	glDeleteProgram(textProgram);
+	if (atlasTexture)
+		glDeleteTextures(1, &atlasTexture);
+}
+
+bool GlCanvas::loadFont(const std::string &fontPath, unsigned int pixelSize)
+{
+	if (!atlas.load(fontPath, pixelSize))
+		return false;
+
+	if (!atlasTexture)
+	{
+		GL_RESOURCE_SITE("GlCanvas font atlas");
+		glGenTextures(1, &atlasTexture);
+	}
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas.width(), atlas.height(), 0, GL_RED, GL_UNSIGNED_BYTE, atlas.pixels().data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+void GlCanvas::clear(const glm::vec4 &color)
+{
+	glClearColor(color.r, color.g, color.b, color.a);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void GlCanvas::drawGeometry(GLenum mode, const glm::vec3 *points, size_t count, const glm::vec4 &color, float pointSize)
+{
+	if (count == 0)
+		return;
+	PROFILE_SCOPE("GlCanvas::drawGeometry");
+	ALLOC_TAG("GlCanvas::drawGeometry");
+	PROFILE_GPU_SCOPE("GlCanvas::drawGeometry");
+	glUseProgram(geometryProgram);
+	glUniform4f(colorLocation, color.r, color.g, color.b, color.a);
+	glUniform1f(pointSizeLocation, pointSize);
+	glBindVertexArray(geometryVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, geometryVBO);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), points, GL_STREAM_DRAW);
+	glDrawArrays(mode, 0, static_cast<GLsizei>(count));
+}
+
+void GlCanvas::drawPoints(const glm::vec3 *points, size_t count, float sizeInPixels, const glm::vec4 &color)
+{
+	drawGeometry(GL_POINTS, points, count, color, sizeInPixels);
+}
+
+void GlCanvas::drawLines(const glm::vec3 *points, size_t count, float widthInPixels, const glm::vec4 &color)
+{
+	if (widthInPixels <= 1.0f)
+	{
+		drawGeometry(GL_LINES, points, count, color, 1.0f);
+		return;
+	}
+
+	// Core profile has no wide lines, expand every segment into a quad
+	wideLines.clear();
+	glm::vec2 pixelToNdc(2.0f / canvasWidth, 2.0f / canvasHeight);
+	for (size_t i = 0; i + 1 < count; i += 2)
+	{
+		glm::vec2 a(points[i]), b(points[i + 1]);
+		glm::vec2 direction = (b - a) / pixelToNdc;
+		float length = glm::length(direction);
+		if (length <= 0.0f)
+			continue;
+		glm::vec2 normal = glm::vec2(-direction.y, direction.x) / length * (0.5f * widthInPixels) * pixelToNdc;
+		glm::vec3 a0(a + normal, 0.0f), a1(a - normal, 0.0f), b0(b + normal, 0.0f), b1(b - normal, 0.0f);
+		wideLines.insert(wideLines.end(), {a0, a1, b0, b0, a1, b1});
+	}
+	drawGeometry(GL_TRIANGLES, wideLines.data(), wideLines.size(), color, 1.0f);
+}
+
+void GlCanvas::drawTriangles(const glm::vec3 *points, size_t count, const glm::vec4 &color)
+{
+	drawGeometry(GL_TRIANGLES, points, count, color, 1.0f);
+}
+
+void GlCanvas::drawText(const std::string &text, float x, float y, float scale, const glm::vec3 &color)
+{
+	if (!atlasTexture)
+		return;
+
+	quads.clear();
+	atlas.layoutText(text, x, y, scale, quads);
+	if (quads.empty())
+		return;
+
+	PROFILE_SCOPE("GlCanvas::drawText");
+	ALLOC_TAG("GlCanvas::drawText");
+	PROFILE_GPU_SCOPE("GlCanvas::drawText");
+	textVertices.clear();
+	for (const GlyphQuad &q : quads)
+	{
+		float vertices[6][4] = {
+			{ q.x0, q.y1, q.u0, q.v0 },
+			{ q.x0, q.y0, q.u0, q.v1 },
+			{ q.x1, q.y0, q.u1, q.v1 },
+
+			{ q.x0, q.y1, q.u0, q.v0 },
+			{ q.x1, q.y0, q.u1, q.v1 },
+			{ q.x1, q.y1, q.u1, q.v0 }
+		};
+		textVertices.insert(textVertices.end(), &vertices[0][0], &vertices[0][0] + 24);
+	}
+
+	glUseProgram(textProgram);
+	glUniform3f(textColorLocation, color.x, color.y, color.z);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glBindVertexArray(textVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+	glBufferData(GL_ARRAY_BUFFER, textVertices.size() * sizeof(float), textVertices.data(), GL_STREAM_DRAW);
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(quads.size() * 6));
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
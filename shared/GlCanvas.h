@@ -0,0 +1,50 @@
+#ifndef GL_CANVAS_H
+#define GL_CANVAS_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include "Canvas.h"
+#include "GlyphAtlas.h"
+
+// Canvas drawn with GL 3.3. Geometry is streamed through one buffer and text
+// is drawn from a single glyph atlas texture, one draw call per string.
+class GlCanvas : public Canvas
+{
+public:
+	GlCanvas(int width, int height);
+	~GlCanvas() override;
+
+	bool loadFont(const std::string &fontPath, unsigned int pixelSize) override;
+
+	void clear(const glm::vec4 &color) override;
+	void drawPoints(const glm::vec3 *points, size_t count, float sizeInPixels, const glm::vec4 &color) override;
+	void drawLines(const glm::vec3 *points, size_t count, float widthInPixels, const glm::vec4 &color) override;
+	void drawTriangles(const glm::vec3 *points, size_t count, const glm::vec4 &color) override;
+	void drawText(const std::string &text, float x, float y, float scale, const glm::vec3 &color) override;
+	unsigned int fontPixelSize() const override { return atlasTexture ? atlas.pixelSize() : 0; }
+	void flush() override {}
+
+	int width() const override { return canvasWidth; }
+	int height() const override { return canvasHeight; }
+
+private:
+	void drawGeometry(GLenum mode, const glm::vec3 *points, size_t count, const glm::vec4 &color, float pointSize);
+
+	int canvasWidth, canvasHeight;
+	GlyphAtlas atlas;
+	GLuint atlasTexture = 0;
+
+	GLuint geometryProgram = 0, textProgram = 0;
+	GLint colorLocation = -1, pointSizeLocation = -1;
+	GLint textColorLocation = -1;
+	GLuint geometryVAO = 0, geometryVBO = 0;
+	GLuint textVAO = 0, textVBO = 0;
+
+	std::vector<glm::vec3> wideLines;
+	std::vector<GlyphQuad> quads;
+	std::vector<float> textVertices;
+};
+
+#endif
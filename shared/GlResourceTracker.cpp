@@ -0,0 +1,519 @@
+#include "GlResourceTracker.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+	const int TYPE_COUNT = static_cast<int>(GlResourceType::Count);
+	const char *UNTAGGED_SITE = "(untagged)";
+	// Growth past the warmup level that is warned about; each warning doubles it
+	const uint64_t GROWTH_OBJECTS = 16;
+	const uint64_t GROWTH_BYTES = 1024 * 1024;
+	const size_t GROWTH_SITES = 5;
+
+	struct Entry
+	{
+		GlResourceRecord record;
+		// Textures: bytes of every image, face * levels + level
+		std::vector<uint64_t> images;
+		uint64_t mipmapBytes = 0;
+	};
+
+	std::unordered_map<uint64_t, Entry> resources;
+	GlResourceTotals totals;
+	uint64_t peakObjects = 0, peakBytes = 0;
+	const char *currentSite = nullptr;
+	bool installed = false;
+
+	long frames = 0;
+	uint64_t baselineObjects = 0, baselineBytes = 0;
+	uint64_t objectThreshold = GROWTH_OBJECTS, byteThreshold = GROWTH_BYTES;
+	int64_t maxGrowthObjects = 0, maxGrowthBytes = 0;
+
+	// Binding queries go straight to the driver, past the call counter
+	decltype(glad_glGetIntegerv) getIntegerv = nullptr;
+
+	const char *typeNames[] = {
+		"buffer", "vertex array", "texture", "framebuffer", "renderbuffer", "query", "program", "shader"
+	};
+
+	uint64_t key(GlResourceType type, GLuint name)
+	{
+		return (static_cast<uint64_t>(type) << 32) | name;
+	}
+
+	Entry *find(GlResourceType type, GLuint name)
+	{
+		auto it = resources.find(key(type, name));
+		return it == resources.end() ? nullptr : &it->second;
+	}
+
+	void setBytes(Entry &entry, uint64_t bytes)
+	{
+		int type = static_cast<int>(entry.record.handle.type);
+		totals.bytes[type] += bytes - entry.record.bytes;
+		totals.liveBytes += bytes - entry.record.bytes;
+		entry.record.bytes = bytes;
+		peakBytes = std::max(peakBytes, totals.liveBytes);
+	}
+
+	void remove(GlResourceType type, GLuint name)
+	{
+		auto it = resources.find(key(type, name));
+		if (it == resources.end())
+			return;
+		setBytes(it->second, 0);
+		totals.objects[static_cast<int>(type)]--;
+		totals.liveObjects--;
+		resources.erase(it);
+	}
+
+	void add(GlResourceType type, GLuint name)
+	{
+		if (name == 0)
+			return;
+		remove(type, name);
+		Entry &entry = resources[key(type, name)];
+		entry.record.handle = { type, name };
+		entry.record.createdFrame = frames;
+		entry.record.site = currentSite ? currentSite : UNTAGGED_SITE;
+		totals.objects[static_cast<int>(type)]++;
+		totals.liveObjects++;
+		peakObjects = std::max(peakObjects, totals.liveObjects);
+	}
+
+	GLuint boundName(GLenum binding)
+	{
+		if (binding == 0)
+			return 0;
+		GLint name = 0;
+		getIntegerv(binding, &name);
+		return static_cast<GLuint>(name);
+	}
+
+	GLenum bufferBinding(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: return GL_ARRAY_BUFFER_BINDING;
+		case GL_ELEMENT_ARRAY_BUFFER: return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+		case GL_PIXEL_PACK_BUFFER: return GL_PIXEL_PACK_BUFFER_BINDING;
+		case GL_PIXEL_UNPACK_BUFFER: return GL_PIXEL_UNPACK_BUFFER_BINDING;
+		case GL_UNIFORM_BUFFER: return GL_UNIFORM_BUFFER_BINDING;
+		case GL_TRANSFORM_FEEDBACK_BUFFER: return GL_TRANSFORM_FEEDBACK_BUFFER_BINDING;
+		case GL_TEXTURE_BUFFER: return GL_TEXTURE_BINDING_BUFFER;
+		// GL 3.3 queries the copy bindings by the target itself
+		case GL_COPY_READ_BUFFER: return GL_COPY_READ_BUFFER;
+		case GL_COPY_WRITE_BUFFER: return GL_COPY_WRITE_BUFFER;
+		default: return 0;
+		}
+	}
+
+	// Binding query of a texture image target, and which cube face it is
+	GLenum textureBinding(GLenum target, int &face)
+	{
+		face = 0;
+		if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+		{
+			face = static_cast<int>(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X);
+			return GL_TEXTURE_BINDING_CUBE_MAP;
+		}
+		switch (target)
+		{
+		case GL_TEXTURE_2D: return GL_TEXTURE_BINDING_2D;
+		case GL_TEXTURE_RECTANGLE: return GL_TEXTURE_BINDING_RECTANGLE;
+		case GL_TEXTURE_1D_ARRAY: return GL_TEXTURE_BINDING_1D_ARRAY;
+		case GL_TEXTURE_2D_MULTISAMPLE: return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+		case GL_TEXTURE_3D: return GL_TEXTURE_BINDING_3D;
+		case GL_TEXTURE_2D_ARRAY: return GL_TEXTURE_BINDING_2D_ARRAY;
+		case GL_TEXTURE_CUBE_MAP: return GL_TEXTURE_BINDING_CUBE_MAP;
+		// Proxy targets allocate nothing
+		default: return 0;
+		}
+	}
+
+	uint64_t texelBytes(GLint internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_RED: case GL_R8: case GL_R8I: case GL_R8UI: case GL_R8_SNORM: case GL_STENCIL_INDEX8:
+			return 1;
+		case GL_RG: case GL_RG8: case GL_RG8I: case GL_RG8UI: case GL_R16: case GL_R16F: case GL_R16I: case GL_R16UI:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_RGB: case GL_RGB8: case GL_SRGB8: case GL_RGB8I: case GL_RGB8UI:
+			return 3;
+		case GL_RGB16F: case GL_RGB16:
+			return 6;
+		case GL_RGBA16F: case GL_RGBA16: case GL_RG32F: case GL_RGBA16I: case GL_RGBA16UI: case GL_DEPTH32F_STENCIL8:
+			return 8;
+		case GL_RGB32F:
+			return 12;
+		case GL_RGBA32F: case GL_RGBA32I: case GL_RGBA32UI:
+			return 16;
+		default:
+			// RGBA8, sRGB8 alpha8, depth 24/32, 24+8 stencil, R32F, RG16F, 10_10_10_2 and unknown formats
+			return 4;
+		}
+	}
+
+	uint64_t imageBytes(GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth)
+	{
+		return texelBytes(internalFormat) * static_cast<uint64_t>(std::max(width, 0))
+		       * static_cast<uint64_t>(std::max(height, 0)) * static_cast<uint64_t>(std::max(depth, 0));
+	}
+
+	void updateTextureBytes(Entry &entry)
+	{
+		uint64_t bytes = entry.mipmapBytes;
+		for (uint64_t image : entry.images)
+			bytes += image;
+		setBytes(entry, bytes);
+	}
+
+	void setTextureImage(GLenum target, GLint level, uint64_t bytes)
+	{
+		int face = 0;
+		Entry *entry = find(GlResourceType::Texture, boundName(textureBinding(target, face)));
+		if (!entry || level < 0)
+			return;
+		const int levels = 16;
+		size_t index = static_cast<size_t>(face * levels + std::min(level, levels - 1));
+		if (entry->images.size() <= index)
+			entry->images.resize(index + 1, 0);
+		entry->images[index] = bytes;
+		updateTextureBytes(*entry);
+	}
+
+	void setRenderbufferStorage(GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height)
+	{
+		Entry *entry = find(GlResourceType::Renderbuffer, boundName(GL_RENDERBUFFER_BINDING));
+		if (entry)
+			setBytes(*entry, imageBytes(static_cast<GLint>(internalFormat), width, height, 1) * std::max(samples, 1));
+	}
+
+	// Live objects grouped by type and site, biggest first
+	struct SiteTotals
+	{
+		GlResourceType type;
+		std::string site;
+		uint64_t objects = 0;
+		uint64_t bytes = 0;
+		long firstFrame = 0;
+		long lastFrame = 0;
+	};
+
+	std::vector<SiteTotals> groupBySite(long createdFrom)
+	{
+		std::map<std::pair<int, std::string>, SiteTotals> groups;
+		for (const auto &resource : resources)
+		{
+			const GlResourceRecord &record = resource.second.record;
+			if (record.createdFrame < createdFrom)
+				continue;
+			auto inserted = groups.emplace(std::make_pair(static_cast<int>(record.handle.type), std::string(record.site)), SiteTotals());
+			SiteTotals &group = inserted.first->second;
+			if (inserted.second)
+			{
+				group.type = record.handle.type;
+				group.site = record.site;
+				group.firstFrame = group.lastFrame = record.createdFrame;
+			}
+			group.objects++;
+			group.bytes += record.bytes;
+			group.firstFrame = std::min(group.firstFrame, record.createdFrame);
+			group.lastFrame = std::max(group.lastFrame, record.createdFrame);
+		}
+		std::vector<SiteTotals> sorted;
+		for (auto &group : groups)
+			sorted.push_back(group.second);
+		std::sort(sorted.begin(), sorted.end(), [](const SiteTotals &a, const SiteTotals &b) {
+			return a.bytes != b.bytes ? a.bytes > b.bytes : a.objects > b.objects;
+		});
+		return sorted;
+	}
+
+	void printSite(const SiteTotals &group)
+	{
+		std::printf("  %-13s %6llu %12.1f KB  %-28s frames %ld-%ld\n", typeNames[static_cast<int>(group.type)],
+		            static_cast<unsigned long long>(group.objects), group.bytes / 1024.0, group.site.c_str(),
+		            group.firstFrame, group.lastFrame);
+	}
+
+	// Entry points that create and delete objects by name arrays:
+	// X(type, gen entry point, delete entry point)
+#define GL_RESOURCE_GEN_DELETE(X) \
+	X(Buffer, GenBuffers, DeleteBuffers) \
+	X(VertexArray, GenVertexArrays, DeleteVertexArrays) \
+	X(Texture, GenTextures, DeleteTextures) \
+	X(Framebuffer, GenFramebuffers, DeleteFramebuffers) \
+	X(Renderbuffer, GenRenderbuffers, DeleteRenderbuffers) \
+	X(Query, GenQueries, DeleteQueries)
+
+#define GL_RESOURCE_GEN_DELETE_WRAPPERS(type, gen, del) \
+	decltype(glad_gl##gen) real##gen = nullptr; \
+	decltype(glad_gl##del) real##del = nullptr; \
+	void APIENTRY tracked##gen(GLsizei n, GLuint *names) \
+	{ \
+		real##gen(n, names); \
+		for (GLsizei i = 0; i < n; i++) \
+			add(GlResourceType::type, names[i]); \
+	} \
+	void APIENTRY tracked##del(GLsizei n, const GLuint *names) \
+	{ \
+		for (GLsizei i = 0; i < n; i++) \
+			remove(GlResourceType::type, names[i]); \
+		real##del(n, names); \
+	}
+	GL_RESOURCE_GEN_DELETE(GL_RESOURCE_GEN_DELETE_WRAPPERS)
+#undef GL_RESOURCE_GEN_DELETE_WRAPPERS
+
+	decltype(glad_glCreateProgram) realCreateProgram = nullptr;
+	decltype(glad_glDeleteProgram) realDeleteProgram = nullptr;
+	decltype(glad_glCreateShader) realCreateShader = nullptr;
+	decltype(glad_glDeleteShader) realDeleteShader = nullptr;
+	decltype(glad_glBufferData) realBufferData = nullptr;
+	decltype(glad_glTexImage2D) realTexImage2D = nullptr;
+	decltype(glad_glTexImage3D) realTexImage3D = nullptr;
+	decltype(glad_glTexImage2DMultisample) realTexImage2DMultisample = nullptr;
+	decltype(glad_glGenerateMipmap) realGenerateMipmap = nullptr;
+	decltype(glad_glRenderbufferStorage) realRenderbufferStorage = nullptr;
+	decltype(glad_glRenderbufferStorageMultisample) realRenderbufferStorageMultisample = nullptr;
+
+	GLuint APIENTRY trackedCreateProgram()
+	{
+		GLuint program = realCreateProgram();
+		add(GlResourceType::Program, program);
+		return program;
+	}
+
+	void APIENTRY trackedDeleteProgram(GLuint program)
+	{
+		remove(GlResourceType::Program, program);
+		realDeleteProgram(program);
+	}
+
+	GLuint APIENTRY trackedCreateShader(GLenum type)
+	{
+		GLuint shader = realCreateShader(type);
+		add(GlResourceType::Shader, shader);
+		return shader;
+	}
+
+	void APIENTRY trackedDeleteShader(GLuint shader)
+	{
+		remove(GlResourceType::Shader, shader);
+		realDeleteShader(shader);
+	}
+
+	void APIENTRY trackedBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+	{
+		realBufferData(target, size, data, usage);
+		Entry *entry = find(GlResourceType::Buffer, boundName(bufferBinding(target)));
+		if (entry)
+			setBytes(*entry, static_cast<uint64_t>(std::max<GLsizeiptr>(size, 0)));
+	}
+
+	void APIENTRY trackedTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+	                                GLint border, GLenum format, GLenum type, const void *pixels)
+	{
+		realTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+		setTextureImage(target, level, imageBytes(internalformat, width, height, 1));
+	}
+
+	void APIENTRY trackedTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+	                                GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels)
+	{
+		realTexImage3D(target, level, internalformat, width, height, depth, border, format, type, pixels);
+		setTextureImage(target, level, imageBytes(internalformat, width, height, depth));
+	}
+
+	void APIENTRY trackedTexImage2DMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width,
+	                                           GLsizei height, GLboolean fixedsamplelocations)
+	{
+		realTexImage2DMultisample(target, samples, internalformat, width, height, fixedsamplelocations);
+		setTextureImage(target, 0, imageBytes(static_cast<GLint>(internalformat), width, height, 1) * std::max(samples, 1));
+	}
+
+	void APIENTRY trackedGenerateMipmap(GLenum target)
+	{
+		realGenerateMipmap(target);
+		int face = 0;
+		Entry *entry = find(GlResourceType::Texture, boundName(textureBinding(target, face)));
+		if (!entry)
+			return;
+		// A full chain below the base levels adds a third of their size
+		const int levels = 16;
+		uint64_t baseBytes = 0;
+		for (size_t i = 0; i < entry->images.size(); i += levels)
+			baseBytes += entry->images[i];
+		entry->mipmapBytes = baseBytes / 3;
+		updateTextureBytes(*entry);
+	}
+
+	void APIENTRY trackedRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+	{
+		realRenderbufferStorage(target, internalformat, width, height);
+		setRenderbufferStorage(1, internalformat, width, height);
+	}
+
+	void APIENTRY trackedRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalformat,
+	                                                    GLsizei width, GLsizei height)
+	{
+		realRenderbufferStorageMultisample(target, samples, internalformat, width, height);
+		setRenderbufferStorage(samples, internalformat, width, height);
+	}
+
+	// Every entry point above that is not a gen/delete pair
+#define GL_RESOURCE_ENTRY_POINTS(X) \
+	X(CreateProgram) \
+	X(DeleteProgram) \
+	X(CreateShader) \
+	X(DeleteShader) \
+	X(BufferData) \
+	X(TexImage2D) \
+	X(TexImage3D) \
+	X(TexImage2DMultisample) \
+	X(GenerateMipmap) \
+	X(RenderbufferStorage) \
+	X(RenderbufferStorageMultisample)
+}
+
+GlResourceSite::GlResourceSite(const char *site)
+	: previous(currentSite)
+{
+	currentSite = site;
+}
+
+GlResourceSite::~GlResourceSite()
+{
+	currentSite = previous;
+}
+
+void installGlResourceTracker()
+{
+	if (installed)
+		return;
+	getIntegerv = glad_glGetIntegerv;
+#define GL_RESOURCE_INSTALL(name) \
+	real##name = glad_gl##name; \
+	if (real##name) \
+		glad_gl##name = tracked##name;
+#define GL_RESOURCE_INSTALL_PAIR(type, gen, del) GL_RESOURCE_INSTALL(gen) GL_RESOURCE_INSTALL(del)
+	GL_RESOURCE_GEN_DELETE(GL_RESOURCE_INSTALL_PAIR)
+	GL_RESOURCE_ENTRY_POINTS(GL_RESOURCE_INSTALL)
+#undef GL_RESOURCE_INSTALL_PAIR
+#undef GL_RESOURCE_INSTALL
+	installed = true;
+}
+
+void uninstallGlResourceTracker()
+{
+	if (!installed)
+		return;
+#define GL_RESOURCE_UNINSTALL(name) \
+	if (real##name) \
+		glad_gl##name = real##name;
+#define GL_RESOURCE_UNINSTALL_PAIR(type, gen, del) GL_RESOURCE_UNINSTALL(gen) GL_RESOURCE_UNINSTALL(del)
+	GL_RESOURCE_GEN_DELETE(GL_RESOURCE_UNINSTALL_PAIR)
+	GL_RESOURCE_ENTRY_POINTS(GL_RESOURCE_UNINSTALL)
+#undef GL_RESOURCE_UNINSTALL_PAIR
+#undef GL_RESOURCE_UNINSTALL
+	installed = false;
+}
+
+bool isGlResourceTrackerInstalled()
+{
+	return installed;
+}
+
+void glResourceTrackerFrame()
+{
+	frames++;
+	PROFILE_COUNTER("GL live objects", static_cast<double>(totals.liveObjects));
+	PROFILE_COUNTER("GL live MB", totals.liveBytes / (1024.0 * 1024.0));
+
+	if (frames == GL_RESOURCE_WARMUP_FRAMES)
+	{
+		baselineObjects = totals.liveObjects;
+		baselineBytes = totals.liveBytes;
+		return;
+	}
+	if (frames < GL_RESOURCE_WARMUP_FRAMES)
+		return;
+
+	int64_t growthObjects = static_cast<int64_t>(totals.liveObjects) - static_cast<int64_t>(baselineObjects);
+	int64_t growthBytes = static_cast<int64_t>(totals.liveBytes) - static_cast<int64_t>(baselineBytes);
+	maxGrowthObjects = std::max(maxGrowthObjects, growthObjects);
+	maxGrowthBytes = std::max(maxGrowthBytes, growthBytes);
+	bool objectsGrew = growthObjects >= static_cast<int64_t>(objectThreshold);
+	bool bytesGrew = growthBytes >= static_cast<int64_t>(byteThreshold);
+	if (!objectsGrew && !bytesGrew)
+		return;
+
+	// Without new objects the growth is storage respecified bigger, show where the bytes are
+	std::vector<SiteTotals> sites = groupBySite(GL_RESOURCE_WARMUP_FRAMES);
+	bool newObjects = !sites.empty();
+	if (!newObjects)
+		sites = groupBySite(0);
+	std::printf("WARNING::GL_RESOURCES: %lld more live GL objects (%+.1f KB) after frame %ld than at the end of the warmup, %s:\n",
+	            static_cast<long long>(growthObjects), growthBytes / 1024.0, frames - 1,
+	            newObjects ? "created by" : "largest live objects");
+	for (size_t i = 0; i < std::min(sites.size(), GROWTH_SITES); i++)
+		printSite(sites[i]);
+	while (objectsGrew && growthObjects >= static_cast<int64_t>(objectThreshold))
+		objectThreshold *= 2;
+	while (bytesGrew && growthBytes >= static_cast<int64_t>(byteThreshold))
+		byteThreshold *= 2;
+}
+
+const GlResourceTotals &glResourceTotals()
+{
+	return totals;
+}
+
+const GlResourceRecord *glFindResource(GlResourceHandle handle)
+{
+	Entry *entry = find(handle.type, handle.name);
+	return entry ? &entry->record : nullptr;
+}
+
+const char *glResourceTypeName(GlResourceType type)
+{
+	return typeNames[static_cast<int>(type)];
+}
+
+void printGlResourceReport()
+{
+	std::printf("GL resources over %ld frames: peak %llu objects, %.1f MB\n", frames,
+	            static_cast<unsigned long long>(peakObjects), peakBytes / (1024.0 * 1024.0));
+	if (frames > GL_RESOURCE_WARMUP_FRAMES)
+	{
+		if (maxGrowthObjects <= 0 && maxGrowthBytes <= 0)
+			std::printf("  flat after the %ld warmup frames\n", GL_RESOURCE_WARMUP_FRAMES);
+		else
+			std::printf("  grew by up to %lld objects, %lld bytes after the %ld warmup frames\n",
+			            static_cast<long long>(maxGrowthObjects), static_cast<long long>(maxGrowthBytes),
+			            GL_RESOURCE_WARMUP_FRAMES);
+	}
+
+	if (totals.liveObjects == 0)
+	{
+		std::printf("  no GL objects leaked\n");
+		return;
+	}
+	std::printf("WARNING::GL_RESOURCES: %llu GL objects (%.1f KB) were never deleted:",
+	            static_cast<unsigned long long>(totals.liveObjects), totals.liveBytes / 1024.0);
+	for (int i = 0; i < TYPE_COUNT; i++)
+		if (totals.objects[i] > 0)
+			std::printf(" %s %llu", typeNames[i], static_cast<unsigned long long>(totals.objects[i]));
+	std::printf("\n");
+	for (const SiteTotals &group : groupBySite(0))
+		printSite(group);
+}
@@ -0,0 +1,103 @@
+#ifndef GL_RESOURCE_TRACKER_H
+#define GL_RESOURCE_TRACKER_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+// Registry of every live GL object: buffers, vertex arrays, textures,
+// framebuffers, renderbuffers, queries, programs and shaders. Like the call
+// counter it swaps glad's function pointers, here for the glGen*, glCreate*
+// and glDelete* entry points and the calls that size storage (glBufferData,
+// glTexImage2D, glGenerateMipmap, glRenderbufferStorage*). Each object is
+// recorded with its type, the bytes it holds, the frame it was created on and
+// its creation site, the innermost GL_RESOURCE_SITE around the call:
+//
+//   GL_RESOURCE_SITE("GlCanvas");      attributes objects created in the block
+//
+// Sizes are what the storage needs, not what the driver pads it to. Programs,
+// shaders, queries, vertex arrays and framebuffers count as objects only.
+//
+// Enabled with --gl-resources. Once the warmup frames are over, the live
+// object count and bytes should stay flat: every time they grow past the
+// level at the end of the warmup by more than a threshold, a warning lists the
+// sites the new objects came from and the threshold doubles. At exit the
+// objects that were never deleted are reported, grouped by type and site.
+
+enum class GlResourceType : int
+{
+	Buffer,
+	VertexArray,
+	Texture,
+	Framebuffer,
+	Renderbuffer,
+	Query,
+	Program,
+	Shader,
+	Count
+};
+
+// Typed handle of a GL object, the key of the registry
+struct GlResourceHandle
+{
+	GlResourceType type;
+	GLuint name;
+};
+
+struct GlResourceRecord
+{
+	GlResourceHandle handle;
+	uint64_t bytes = 0;
+	long createdFrame = 0;
+	const char *site = nullptr;
+};
+
+struct GlResourceTotals
+{
+	uint64_t objects[static_cast<int>(GlResourceType::Count)] = {};
+	uint64_t bytes[static_cast<int>(GlResourceType::Count)] = {};
+	uint64_t liveObjects = 0;
+	uint64_t liveBytes = 0;
+};
+
+const long GL_RESOURCE_WARMUP_FRAMES = 3;
+
+class GlResourceSite
+{
+public:
+	explicit GlResourceSite(const char *site);
+	~GlResourceSite();
+
+	GlResourceSite(const GlResourceSite&) = delete;
+	GlResourceSite& operator=(const GlResourceSite&) = delete;
+
+private:
+	const char *previous;
+};
+
+// Must be called after gladLoadGLLoader, with the context current, and before
+// installGlCallCounter so the counter still sees every call. Objects that
+// exist before it are not tracked and deleting them is ignored.
+void installGlResourceTracker();
+void uninstallGlResourceTracker();
+bool isGlResourceTrackerInstalled();
+
+// Called once per frame: stamps new objects with the next frame number and
+// checks the live totals for growth.
+void glResourceTrackerFrame();
+// Live objects and bytes right now, by type and in total.
+const GlResourceTotals &glResourceTotals();
+// The record of a live object, nullptr if it is not tracked.
+const GlResourceRecord *glFindResource(GlResourceHandle handle);
+const char *glResourceTypeName(GlResourceType type);
+
+// Prints the peak totals, whether memory stayed flat after the warmup and
+// every object that is still alive. Call before the GL context goes away,
+// once everything the context owns is deleted.
+void printGlResourceReport();
+
+#define GL_RESOURCE_CONCAT_INNER(a, b) a##b
+#define GL_RESOURCE_CONCAT(a, b) GL_RESOURCE_CONCAT_INNER(a, b)
+#define GL_RESOURCE_SITE(site) GlResourceSite GL_RESOURCE_CONCAT(glResourceSite, __LINE__)(site)
+
+#endif
@@ -0,0 +1,127 @@
+#include "GlyphAtlas.h"
+#include "Profiler.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+bool GlyphAtlas::load(const std::string &fontPath, unsigned int pixelSize)
+{
+	PROFILE_SCOPE("GlyphAtlas::load");
+	FT_Library ft;
+	if (FT_Init_FreeType(&ft))
+	{
+		std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+		return false;
+	}
+	FT_Face face;
+	if (FT_New_Face(ft, fontPath.c_str(), 0, &face))
+	{
+		std::cout << "ERROR::FREETYPE: Failed to load font " << fontPath << std::endl;
+		FT_Done_FreeType(ft);
+		return false;
+	}
+	FT_Set_Pixel_Sizes(face, 0, pixelSize);
+	fontPixelSize = pixelSize;
+
+	// Rasterize everything first, then shelf-pack into rows of the atlas
+	struct Rendered
+	{
+		std::vector<unsigned char> pixels;
+		int width, height;
+	};
+	std::array<Rendered, 128> rendered {};
+	int shelfX = 1, shelfY = 1, shelfHeight = 0;
+	for (unsigned char c = 0; c < 128; c++)
+	{
+		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+		{
+			std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+			continue;
+		}
+		const FT_Bitmap &source = face->glyph->bitmap;
+		Rendered &r = rendered[c];
+		r.width = static_cast<int>(source.width);
+		r.height = static_cast<int>(source.rows);
+		r.pixels.resize(static_cast<size_t>(r.width) * r.height);
+		for (int row = 0; row < r.height; row++)
+			std::memcpy(&r.pixels[row * r.width], source.buffer + row * source.pitch, r.width);
+
+		// One pixel gap keeps linear filtering from bleeding between glyphs
+		if (shelfX + r.width + 1 > atlasWidth)
+		{
+			shelfX = 1;
+			shelfY += shelfHeight + 1;
+			shelfHeight = 0;
+		}
+		Glyph &g = glyphs[c];
+		g.atlasX = shelfX;
+		g.atlasY = shelfY;
+		g.width = r.width;
+		g.height = r.height;
+		g.bearingX = face->glyph->bitmap_left;
+		g.bearingY = face->glyph->bitmap_top;
+		g.advance = static_cast<int>(face->glyph->advance.x >> 6);
+		shelfX += r.width + 1;
+		shelfHeight = std::max(shelfHeight, r.height);
+	}
+	FT_Done_Face(face);
+	FT_Done_FreeType(ft);
+
+	atlasHeight = shelfY + shelfHeight + 1;
+	bitmap.assign(static_cast<size_t>(atlasWidth) * atlasHeight, 0);
+	for (int c = 0; c < 128; c++)
+	{
+		const Glyph &g = glyphs[c];
+		for (int row = 0; row < g.height; row++)
+			std::memcpy(&bitmap[(g.atlasY + row) * atlasWidth + g.atlasX], &rendered[c].pixels[row * g.width], g.width);
+	}
+	return true;
+}
+
+void GlyphAtlas::layoutText(const std::string &text, float x, float y, float scale, std::vector<GlyphQuad> &quads) const
+{
+	float inverseWidth = 1.0f / atlasWidth;
+	float inverseHeight = 1.0f / atlasHeight;
+	float startX = x;
+	for (char c : text)
+	{
+		if (c == '\n')
+		{
+			x = startX;
+			y -= LINE_SPACING * fontPixelSize * scale;
+			continue;
+		}
+		const Glyph &g = glyph(static_cast<unsigned char>(c));
+		float xpos = x + g.bearingX * scale;
+		float ypos = y - (g.height - g.bearingY) * scale;
+		if (g.width > 0 && g.height > 0)
+		{
+			quads.push_back({
+				xpos, ypos, xpos + g.width * scale, ypos + g.height * scale,
+				g.atlasX * inverseWidth, g.atlasY * inverseHeight,
+				(g.atlasX + g.width) * inverseWidth, (g.atlasY + g.height) * inverseHeight
+			});
+		}
+		x += g.advance * scale;
+	}
+}
+
+float GlyphAtlas::textWidth(const std::string &text, float scale) const
+{
+	float width = 0.0f, lineWidth = 0.0f;
+	for (char c : text)
+	{
+		if (c == '\n')
+		{
+			width = std::max(width, lineWidth);
+			lineWidth = 0.0f;
+			continue;
+		}
+		lineWidth += glyph(static_cast<unsigned char>(c)).advance * scale;
+	}
+	return std::max(width, lineWidth);
+}
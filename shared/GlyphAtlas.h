@@ -0,0 +1,57 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+// Placement of one glyph inside the atlas, in pixels
+struct Glyph
+{
+	int atlasX = 0, atlasY = 0;   // top-left corner in the atlas
+	int width = 0, height = 0;
+	int bearingX = 0, bearingY = 0;
+	int advance = 0;
+};
+
+// A text quad in pixel coordinates (origin bottom-left, like renderText) and
+// its normalized atlas coordinates; v0 belongs to the top edge y1.
+struct GlyphQuad
+{
+	float x0, y0, x1, y1;
+	float u0, v0, u1, v1;
+};
+
+// The first 128 characters of a font rasterized by FreeType into a single
+// 8-bit coverage bitmap, so a whole string can be drawn from one texture
+// (or blitted by the software rasterizer) instead of one texture per glyph.
+class GlyphAtlas
+{
+public:
+	static constexpr float LINE_SPACING = 1.25f;
+
+	bool load(const std::string &fontPath, unsigned int pixelSize);
+	bool isLoaded() const { return !bitmap.empty(); }
+
+	const Glyph &glyph(unsigned char c) const { return glyphs[c & 0x7f]; }
+	unsigned int pixelSize() const { return fontPixelSize; }
+	int width() const { return atlasWidth; }
+	int height() const { return atlasHeight; }
+	// Rows are stored top-down, atlasWidth bytes each
+	const std::vector<unsigned char> &pixels() const { return bitmap; }
+
+	// Lays out `text` with the same metrics as TextRenderer::renderText.
+	// A '\n' starts a new line LINE_SPACING font sizes below, back at `x`.
+	void layoutText(const std::string &text, float x, float y, float scale, std::vector<GlyphQuad> &quads) const;
+	// Width of the longest line
+	float textWidth(const std::string &text, float scale) const;
+
+private:
+	std::array<Glyph, 128> glyphs {};
+	std::vector<unsigned char> bitmap;
+	int atlasWidth = 1024;
+	int atlasHeight = 0;
+	unsigned int fontPixelSize = 0;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "JobSystem.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+namespace {
+	// Identifies which system and queue the calling thread belongs to.
+	thread_local const JobSystem *tlsOwner = nullptr;
+	thread_local unsigned int tlsWorkerIndex = 0;
+}
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	if (workerCount == 0)
+		workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < workerCount; i++)
+		queues.push_back(std::make_unique<WorkQueue>());
+
+	tlsOwner = this;
+	tlsWorkerIndex = 0;
+
+	// Worker 0 is the calling thread, it only runs jobs while waiting.
+	for (unsigned int i = 1; i < workerCount; i++)
+		workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+	wakeCondition.notify_all();
+	for (std::thread &worker : workers)
+		worker.join();
+
+	if (tlsOwner == this)
+		tlsOwner = nullptr;
+}
+
+JobHandle JobSystem::createJob(std::function<void()> function)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->function = std::move(function);
+	return job;
+}
+
+void JobSystem::addDependency(const JobHandle &job, const JobHandle &dependency)
+{
+	std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+	if (dependency->finished)
+		return;
+	job->pendingDependencies++;
+	dependency->continuations.push_back(job);
+}
+
+void JobSystem::submit(const JobHandle &job)
+{
+	if (--job->pendingDependencies == 0)
+		enqueue(job);
+}
+
+void JobSystem::wait(const JobHandle &job)
+{
+	unsigned int workerIndex = currentWorker();
+	while (!job->finished)
+	{
+		if (!runOne(workerIndex))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::waitAll(const std::vector<JobHandle> &jobs)
+{
+	for (const JobHandle &job : jobs)
+		wait(job);
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize,
+                            const std::function<void(size_t, size_t)> &body)
+{
+	if (begin >= end)
+		return;
+	grainSize = std::max<size_t>(grainSize, 1);
+
+	// Small ranges are not worth the scheduling round trip.
+	if (end - begin <= grainSize || queues.size() == 1)
+	{
+		body(begin, end);
+		return;
+	}
+
+	std::vector<JobHandle> chunks;
+	chunks.reserve((end - begin + grainSize - 1) / grainSize);
+	for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+	{
+		size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+		chunks.push_back(createJob([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }));
+	}
+	for (const JobHandle &chunk : chunks)
+		submit(chunk);
+	waitAll(chunks);
+}
+
+void JobSystem::workerLoop(unsigned int workerIndex)
+{
+	tlsOwner = this;
+	tlsWorkerIndex = workerIndex;
+	PROFILE_THREAD_NAME("job worker " + std::to_string(workerIndex));
+	ALLOC_THREAD_NAME("job worker " + std::to_string(workerIndex));
+
+	while (running)
+	{
+		if (runOne(workerIndex))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeCondition.wait(lock, [this]() { return !running || queuedJobs > 0; });
+	}
+}
+
+void JobSystem::enqueue(const JobHandle &job)
+{
+	WorkQueue &queue = *queues[currentWorker()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedJobs++;
+	}
+	wakeCondition.notify_one();
+}
+
+bool JobSystem::runOne(unsigned int workerIndex)
+{
+	JobHandle job = pop(workerIndex);
+	if (!job)
+		job = steal(workerIndex);
+	if (!job)
+		return false;
+
+	queuedJobs--;
+	execute(job);
+	return true;
+}
+
+JobHandle JobSystem::pop(unsigned int workerIndex)
+{
+	WorkQueue &queue = *queues[workerIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return nullptr;
+	JobHandle job = std::move(queue.jobs.back());
+	queue.jobs.pop_back();
+	return job;
+}
+
+JobHandle JobSystem::steal(unsigned int thiefIndex)
+{
+	unsigned int count = static_cast<unsigned int>(queues.size());
+	for (unsigned int offset = 1; offset < count; offset++)
+	{
+		WorkQueue &victim = *queues[(thiefIndex + offset) % count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.jobs.empty())
+			continue;
+		JobHandle job = std::move(victim.jobs.front());
+		victim.jobs.pop_front();
+		return job;
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(const JobHandle &job)
+{
+	job->function();
+
+	std::vector<JobHandle> ready;
+	{
+		std::lock_guard<std::mutex> lock(job->continuationMutex);
+		job->finished = true;
+		for (JobHandle &continuation : job->continuations)
+		{
+			if (--continuation->pendingDependencies == 0)
+				ready.push_back(continuation);
+		}
+		job->continuations.clear();
+	}
+	for (const JobHandle &continuation : ready)
+		enqueue(continuation);
+}
+
+unsigned int JobSystem::currentWorker() const
+{
+	return tlsOwner == this ? tlsWorkerIndex : 0;
+}
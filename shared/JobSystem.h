@@ -0,0 +1,80 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work. Jobs only become runnable once every job they depend on
+// has finished, so per-frame work can be expressed as a small graph and
+// joined before any GL call is made.
+struct Job
+{
+	std::function<void()> function;
+	std::atomic<int> pendingDependencies {1}; // 1 is the token released by submit()
+	std::atomic<bool> finished {false};
+	std::mutex continuationMutex;
+	std::vector<std::shared_ptr<Job>> continuations;
+};
+
+using JobHandle = std::shared_ptr<Job>;
+
+// Work-stealing scheduler. Every worker owns a deque: it pushes and pops its
+// own work at the back while idle workers steal from the front of the others.
+// The thread that constructs the system is worker 0 and takes part in the
+// work whenever it waits on a job.
+class JobSystem
+{
+public:
+	// workerCount == 0 picks one worker per hardware thread.
+	explicit JobSystem(unsigned int workerCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	JobHandle createJob(std::function<void()> function);
+	// `job` will not start before `dependency` has finished. Must be called before submit(job).
+	void addDependency(const JobHandle &job, const JobHandle &dependency);
+	void submit(const JobHandle &job);
+	// Runs other jobs on the calling thread until `job` has finished.
+	void wait(const JobHandle &job);
+	void waitAll(const std::vector<JobHandle> &jobs);
+
+	// Splits [begin, end) into chunks of at most grainSize elements and calls
+	// body(chunkBegin, chunkEnd) for each of them in parallel. Returns once all chunks are done.
+	void parallelFor(size_t begin, size_t end, size_t grainSize,
+	                 const std::function<void(size_t, size_t)> &body);
+
+	unsigned int workerCount() const { return static_cast<unsigned int>(queues.size()); }
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	void workerLoop(unsigned int workerIndex);
+	void enqueue(const JobHandle &job);
+	bool runOne(unsigned int workerIndex);
+	JobHandle pop(unsigned int workerIndex);
+	JobHandle steal(unsigned int thiefIndex);
+	void execute(const JobHandle &job);
+	unsigned int currentWorker() const;
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<bool> running {true};
+	std::atomic<int> queuedJobs {0};
+	std::mutex sleepMutex;
+	std::condition_variable wakeCondition;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "LayerCache.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+#include "Profiler.h"
+#include "RenderContext.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+	// One triangle covering the viewport, generated from gl_VertexID
+	const char* compositeVertexShaderSource = R"(
+		#version 330 core
+		void main() {
+			vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+			gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+		}
+	)";
+
+	// Layers have the size of the frame, so every fragment reads exactly its own texel
+	const char* compositeFragmentShaderSource = R"(
+		#version 330 core
+		out vec4 FragColor;
+		uniform sampler2D layer;
+		void main() {
+			FragColor = texelFetch(layer, ivec2(gl_FragCoord.xy), 0);
+		}
+	)";
+}
+
+LayerCache::~LayerCache()
+{
+	release();
+}
+
+bool LayerCache::setup(RenderContext &renderContext, unsigned int layerCount)
+{
+	release();
+	context = &renderContext;
+	layers.resize(layerCount);
+
+	passthrough = renderContext.isSoftware();
+	if (passthrough)
+		return true;
+
+	GL_RESOURCE_SITE("LayerCache");
+	program = loadProgram("LayerCache composite", compositeVertexShaderSource, compositeFragmentShaderSource);
+	if (!program)
+	{
+		std::cout << "ERROR::LAYER_CACHE: Failed to build the composite program" << std::endl;
+		release();
+		return false;
+	}
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "layer"), 0);
+
+	// Core profile draws need a vertex array even without attributes
+	glGenVertexArrays(1, &VAO);
+
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	samples = std::min(renderContext.renderOptions().samples, static_cast<int>(maxSamples));
+	width = renderContext.width();
+	height = renderContext.height();
+	return true;
+}
+
+void LayerCache::release()
+{
+	for (Layer &layer : layers)
+		deleteTargets(layer);
+	layers.clear();
+	if (program)
+		glDeleteProgram(program);
+	if (VAO)
+		glDeleteVertexArrays(1, &VAO);
+	program = 0;
+	VAO = 0;
+	activeLayer = -1;
+}
+
+bool LayerCache::createTargets(Layer &layer)
+{
+	GL_RESOURCE_SITE("LayerCache layer");
+	glGenTextures(1, &layer.texture);
+	glBindTexture(GL_TEXTURE_2D, layer.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &layer.resolveFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, layer.resolveFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.texture, 0);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	// Without MSAA the layer is drawn straight into its texture
+	if (complete && samples > 1)
+	{
+		glGenRenderbuffers(1, &layer.colorRenderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, layer.colorRenderbuffer);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glGenFramebuffers(1, &layer.drawFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, layer.drawFBO);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, layer.colorRenderbuffer);
+		complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, context->drawFramebuffer());
+
+	if (!complete)
+	{
+		std::cout << "ERROR::LAYER_CACHE: Layer framebuffer is not complete" << std::endl;
+		deleteTargets(layer);
+	}
+	return complete;
+}
+
+void LayerCache::deleteTargets(Layer &layer)
+{
+	if (layer.drawFBO)
+		glDeleteFramebuffers(1, &layer.drawFBO);
+	if (layer.colorRenderbuffer)
+		glDeleteRenderbuffers(1, &layer.colorRenderbuffer);
+	if (layer.resolveFBO)
+		glDeleteFramebuffers(1, &layer.resolveFBO);
+	if (layer.texture)
+		glDeleteTextures(1, &layer.texture);
+	layer = Layer();
+}
+
+bool LayerCache::begin(unsigned int layer)
+{
+	if (layer >= layers.size())
+		return false;
+	if (passthrough)
+		return true;
+
+	// A resized window makes every layer the wrong size
+	if (width != context->width() || height != context->height())
+	{
+		for (Layer &l : layers)
+			deleteTargets(l);
+		width = context->width();
+		height = context->height();
+	}
+
+	Layer &target = layers[layer];
+	if (target.valid)
+		return false;
+	if (!target.texture && !createTargets(target))
+		return true; // draw into the frame directly rather than lose the content
+
+	activeLayer = static_cast<int>(layer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.drawFBO ? target.drawFBO : target.resolveFBO);
+	glViewport(0, 0, width, height);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// Keep color premultiplied and accumulate coverage in alpha
+	glGetIntegerv(GL_BLEND_SRC_RGB, &savedBlend[0]);
+	glGetIntegerv(GL_BLEND_DST_RGB, &savedBlend[1]);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &savedBlend[2]);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &savedBlend[3]);
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	return true;
+}
+
+void LayerCache::end()
+{
+	if (activeLayer < 0)
+		return;
+
+	Layer &target = layers[activeLayer];
+	if (target.drawFBO)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, target.drawFBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.resolveFBO);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	target.valid = true;
+	activeLayer = -1;
+
+	glBlendFuncSeparate(savedBlend[0], savedBlend[1], savedBlend[2], savedBlend[3]);
+	glBindFramebuffer(GL_FRAMEBUFFER, context->drawFramebuffer());
+}
+
+void LayerCache::composite(unsigned int layer)
+{
+	if (passthrough || !isValid(layer))
+		return;
+	PROFILE_GPU_SCOPE("LayerCache::composite");
+
+	GLint blend[4];
+	glGetIntegerv(GL_BLEND_SRC_RGB, &blend[0]);
+	glGetIntegerv(GL_BLEND_DST_RGB, &blend[1]);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend[2]);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &blend[3]);
+	GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glUseProgram(program);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, layers[layer].texture);
+	glBindVertexArray(VAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBlendFuncSeparate(blend[0], blend[1], blend[2], blend[3]);
+	if (!blendEnabled)
+		glDisable(GL_BLEND);
+}
+
+void LayerCache::invalidate(unsigned int layer)
+{
+	if (layer < layers.size())
+		layers[layer].valid = false;
+}
+
+void LayerCache::invalidateAll()
+{
+	for (Layer &layer : layers)
+		layer.valid = false;
+}
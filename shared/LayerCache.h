@@ -0,0 +1,69 @@
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+class RenderContext;
+
+// Offscreen copies of content that does not change from frame to frame.
+// A layer is drawn once into its own framebuffer and then composited with a
+// single full-screen triangle each frame until it is invalidated:
+//
+//   if (layers.begin(STATIC_LAYER)) {
+//       ... draw labels, points, finished edges ...
+//       layers.end();
+//   }
+//   layers.composite(STATIC_LAYER);
+//
+// Layers hold premultiplied color: begin() switches the blend function so
+// that drawing into a transparent layer and compositing it gives the same
+// picture as drawing straight into the frame. Layers are multisampled like
+// the frame and resolved into a texture in end().
+//
+// Without a GL context (--software) nothing is cached: begin() always returns
+// true and the content is drawn directly, in the order of the calls.
+class LayerCache
+{
+public:
+	~LayerCache();
+
+	bool setup(RenderContext &context, unsigned int layerCount);
+	void release();
+
+	// Returns true if `layer` must be redrawn. The layer framebuffer is then
+	// bound and cleared, and end() has to be called once it is drawn.
+	bool begin(unsigned int layer);
+	// Resolves the layer and binds the context's framebuffer again.
+	void end();
+	// Draws the layer over whatever the frame holds so far.
+	void composite(unsigned int layer);
+
+	void invalidate(unsigned int layer);
+	void invalidateAll();
+	bool isValid(unsigned int layer) const { return layer < layers.size() && layers[layer].valid; }
+
+private:
+	struct Layer
+	{
+		GLuint drawFBO = 0, colorRenderbuffer = 0;
+		GLuint resolveFBO = 0, texture = 0;
+		bool valid = false;
+	};
+
+	bool createTargets(Layer &layer);
+	void deleteTargets(Layer &layer);
+
+	RenderContext *context = nullptr;
+	bool passthrough = false;
+	int width = 0, height = 0, samples = 0;
+	std::vector<Layer> layers;
+	int activeLayer = -1;
+	GLint savedBlend[4] = {};
+
+	GLuint program = 0;
+	GLuint VAO = 0;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include "Morph.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+	const char* morphVertexShaderSource = R"(
+		#version 330 core
+		layout (location = 0) in vec2 aFrom;
+		layout (location = 1) in vec2 aTo;
+		uniform float blend;
+		void main() {
+			gl_Position = vec4(mix(aFrom, aTo, blend), 0.0, 1.0);
+		}
+	)";
+
+	const char* morphFragmentShaderSource = R"(
+		#version 330 core
+		out vec4 FragColor;
+		uniform vec4 color;
+		void main() {
+			FragColor = color;
+		}
+	)";
+
+	float signedArea(const std::vector<glm::vec2> &outline)
+	{
+		float area = 0.0f;
+		for (size_t i = 0; i < outline.size(); i++)
+		{
+			const glm::vec2 &a = outline[i];
+			const glm::vec2 &b = outline[(i + 1) % outline.size()];
+			area += a.x * b.y - b.x * a.y;
+		}
+		return area * 0.5f;
+	}
+
+	glm::vec2 centroid(const std::vector<glm::vec2> &outline)
+	{
+		glm::vec2 sum(0.0f);
+		for (const glm::vec2 &p : outline)
+			sum += p;
+		return outline.empty() ? sum : sum / static_cast<float>(outline.size());
+	}
+}
+
+std::vector<glm::vec2> resampleOutline(const std::vector<glm::vec2> &outline, unsigned int count)
+{
+	size_t edgeCount = outline.size();
+	if (edgeCount < 2 || count <= edgeCount)
+		return outline;
+
+	std::vector<float> edgeLengths(edgeCount);
+	float perimeter = 0.0f;
+	for (size_t i = 0; i < edgeCount; i++)
+	{
+		edgeLengths[i] = glm::length(outline[(i + 1) % edgeCount] - outline[i]);
+		perimeter += edgeLengths[i];
+	}
+
+	// Each edge keeps its start corner; the extra samples go to the edges by
+	// length, handing out the rounding leftovers to the largest remainders.
+	unsigned int extra = count - static_cast<unsigned int>(edgeCount);
+	std::vector<unsigned int> interior(edgeCount);
+	std::vector<std::pair<float, size_t>> remainders(edgeCount);
+	unsigned int assigned = 0;
+	for (size_t i = 0; i < edgeCount; i++)
+	{
+		float share = perimeter > 0.0f ? extra * edgeLengths[i] / perimeter : static_cast<float>(extra) / edgeCount;
+		interior[i] = static_cast<unsigned int>(share);
+		remainders[i] = {share - interior[i], i};
+		assigned += interior[i];
+	}
+	std::sort(remainders.begin(), remainders.end(), std::greater<>());
+	for (size_t i = 0; assigned < extra; i++, assigned++)
+		interior[remainders[i % edgeCount].second]++;
+
+	std::vector<glm::vec2> resampled;
+	resampled.reserve(count);
+	for (size_t i = 0; i < edgeCount; i++)
+	{
+		const glm::vec2 &start = outline[i];
+		const glm::vec2 &end = outline[(i + 1) % edgeCount];
+		for (unsigned int k = 0; k <= interior[i]; k++)
+			resampled.push_back(glm::mix(start, end, static_cast<float>(k) / (interior[i] + 1)));
+	}
+	return resampled;
+}
+
+void alignOutlines(const std::vector<glm::vec2> &from, std::vector<glm::vec2> &to)
+{
+	size_t count = from.size();
+	if (count == 0 || to.size() != count)
+		return;
+
+	if ((signedArea(from) < 0.0f) != (signedArea(to) < 0.0f))
+		std::reverse(to.begin(), to.end());
+
+	size_t bestOffset = 0;
+	float bestCost = std::numeric_limits<float>::max();
+	for (size_t offset = 0; offset < count; offset++)
+	{
+		float cost = 0.0f;
+		for (size_t i = 0; i < count && cost < bestCost; i++)
+		{
+			glm::vec2 delta = from[i] - to[(i + offset) % count];
+			cost += glm::dot(delta, delta);
+		}
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestOffset = offset;
+		}
+	}
+	std::rotate(to.begin(), to.begin() + bestOffset, to.end());
+}
+
+MorphMesh::~MorphMesh()
+{
+	release();
+}
+
+bool MorphMesh::setup(const std::vector<glm::vec2> &from, const std::vector<glm::vec2> &to, unsigned int vertexCount)
+{
+	release();
+
+	vertexCount = std::max<unsigned int>({vertexCount, static_cast<unsigned int>(from.size()),
+	                                      static_cast<unsigned int>(to.size())});
+	std::vector<glm::vec2> start = resampleOutline(from, vertexCount);
+	std::vector<glm::vec2> end = resampleOutline(to, vertexCount);
+	if (start.size() != end.size() || start.size() < 3)
+	{
+		std::cout << "ERROR::MORPH: Outlines need at least three vertices" << std::endl;
+		return false;
+	}
+	alignOutlines(start, end);
+
+	// Vertex 0 is the centroid pair used as the fan center, the outline follows.
+	std::vector<glm::vec2> vertices;
+	vertices.reserve((start.size() + 1) * 2);
+	vertices.push_back(centroid(start));
+	vertices.push_back(centroid(end));
+	for (size_t i = 0; i < start.size(); i++)
+	{
+		vertices.push_back(start[i]);
+		vertices.push_back(end[i]);
+	}
+
+	std::vector<unsigned int> indices;
+	GLuint outlineVertices = static_cast<GLuint>(start.size());
+	for (GLuint i = 0; i < outlineVertices; i++)
+	{
+		indices.push_back(0);
+		indices.push_back(1 + i);
+		indices.push_back(1 + (i + 1) % outlineVertices);
+	}
+
+	GL_RESOURCE_SITE("MorphMesh");
+	program = loadProgram("MorphMesh", morphVertexShaderSource, morphFragmentShaderSource);
+	if (!program)
+		return false;
+	blendLocation = glGetUniformLocation(program, "blend");
+	colorLocation = glGetUniformLocation(program, "color");
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+	// Two attribute streams interleaved in one buffer: from.xy, to.xy
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+
+	outlineCount = static_cast<GLsizei>(outlineVertices);
+	fillIndexCount = static_cast<GLsizei>(indices.size());
+	return true;
+}
+
+void MorphMesh::release()
+{
+	if (VAO) glDeleteVertexArrays(1, &VAO);
+	if (VBO) glDeleteBuffers(1, &VBO);
+	if (EBO) glDeleteBuffers(1, &EBO);
+	if (program) glDeleteProgram(program);
+	VAO = VBO = EBO = program = 0;
+	outlineCount = fillIndexCount = 0;
+}
+
+void MorphMesh::bind(float blend, const glm::vec4 &color) const
+{
+	glUseProgram(program);
+	glUniform1f(blendLocation, blend);
+	glUniform4f(colorLocation, color.r, color.g, color.b, color.a);
+	glBindVertexArray(VAO);
+}
+
+void MorphMesh::drawFill(float blend, const glm::vec4 &color) const
+{
+	bind(blend, color);
+	glDrawElements(GL_TRIANGLES, fillIndexCount, GL_UNSIGNED_INT, 0);
+}
+
+void MorphMesh::drawOutline(float blend, const glm::vec4 &color) const
+{
+	bind(blend, color);
+	glDrawArrays(GL_LINE_LOOP, 1, outlineCount);
+}
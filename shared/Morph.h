@@ -0,0 +1,45 @@
+#ifndef MORPH_H
+#define MORPH_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include <glm/glm/glm.hpp>
+
+// Resamples a closed outline to exactly `count` vertices spaced evenly by arc
+// length. Every original corner is kept, the remaining samples are shared
+// between the edges in proportion to their length.
+std::vector<glm::vec2> resampleOutline(const std::vector<glm::vec2> &outline, unsigned int count);
+
+// Rotates (and if the winding differs, reverses) `to` so that to[i] is the
+// vertex closest to from[i] overall. Both outlines must have the same size.
+void alignOutlines(const std::vector<glm::vec2> &from, std::vector<glm::vec2> &to);
+
+// Blends between two outlines on the GPU. The correspondence is computed once
+// in setup(); every vertex holds both its start and end position as separate
+// attributes and the vertex shader mixes them, so a frame costs one uniform
+// update and one draw call regardless of vertex count.
+class MorphMesh
+{
+public:
+	~MorphMesh();
+
+	bool setup(const std::vector<glm::vec2> &from, const std::vector<glm::vec2> &to, unsigned int vertexCount = 64);
+	void release();
+
+	// blend in [0, 1], 0 draws `from`, 1 draws `to`.
+	void drawFill(float blend, const glm::vec4 &color) const;
+	void drawOutline(float blend, const glm::vec4 &color) const;
+
+private:
+	void bind(float blend, const glm::vec4 &color) const;
+
+	GLuint program = 0;
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	GLint blendLocation = -1, colorLocation = -1;
+	GLsizei outlineCount = 0;
+	GLsizei fillIndexCount = 0;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "Path.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace {
+	glm::vec2 evaluateCubic(const PathSegment &s, float t)
+	{
+		float u = 1.0f - t;
+		return (u * u * u) * s.p0 + (3.0f * u * u * t) * s.p1 + (3.0f * u * t * t) * s.p2 + (t * t * t) * s.p3;
+	}
+}
+
+void Path::addQuadratic(const glm::vec2 &p0, const glm::vec2 &p1, const glm::vec2 &p2)
+{
+	// Degree elevation, the cubic traces exactly the same curve.
+	segments.push_back({p0, p0 + (2.0f / 3.0f) * (p1 - p0), p2 + (2.0f / 3.0f) * (p1 - p2), p2});
+}
+
+void Path::addCubic(const glm::vec2 &p0, const glm::vec2 &p1, const glm::vec2 &p2, const glm::vec2 &p3)
+{
+	segments.push_back({p0, p1, p2, p3});
+}
+
+void Path::addCatmullRom(const std::vector<glm::vec2> &points, bool closed)
+{
+	size_t count = points.size();
+	if (count < 2)
+		return;
+
+	auto at = [&points, count, closed](long i) -> const glm::vec2& {
+		if (closed)
+			return points[(i % static_cast<long>(count) + count) % count];
+		return points[std::clamp<long>(i, 0, static_cast<long>(count) - 1)];
+	};
+
+	long segmentTotal = closed ? static_cast<long>(count) : static_cast<long>(count) - 1;
+	for (long i = 0; i < segmentTotal; i++)
+	{
+		const glm::vec2 &previous = at(i - 1);
+		const glm::vec2 &start = at(i);
+		const glm::vec2 &end = at(i + 1);
+		const glm::vec2 &next = at(i + 2);
+		segments.push_back({start, start + (end - previous) / 6.0f, end - (next - start) / 6.0f, end});
+	}
+}
+
+void Path::buildArcLengthTable(unsigned int samples)
+{
+	samplesPerSegment = std::max(1u, samples);
+	lengths.assign(segments.size() * samplesPerSegment + 1, 0.0f);
+
+	float total = 0.0f;
+	glm::vec2 previous = segments.empty() ? glm::vec2(0.0f) : segments.front().p0;
+	for (size_t s = 0; s < segments.size(); s++)
+	{
+		for (unsigned int i = 1; i <= samplesPerSegment; i++)
+		{
+			glm::vec2 current = evaluateCubic(segments[s], static_cast<float>(i) / samplesPerSegment);
+			total += glm::length(current - previous);
+			lengths[s * samplesPerSegment + i] = total;
+			previous = current;
+		}
+	}
+}
+
+glm::vec2 Path::evaluate(float t) const
+{
+	if (segments.empty())
+		return glm::vec2(0.0f);
+
+	t = std::clamp(t, 0.0f, static_cast<float>(segments.size()));
+	size_t index = std::min(static_cast<size_t>(t), segments.size() - 1);
+	return evaluateCubic(segments[index], t - static_cast<float>(index));
+}
+
+float Path::parameterAtDistance(float distance) const
+{
+	if (lengths.size() < 2)
+		return 0.0f;
+
+	distance = std::clamp(distance, 0.0f, lengths.back());
+	// First sample at or beyond the distance, then interpolate within the interval before it.
+	size_t upper = std::lower_bound(lengths.begin() + 1, lengths.end(), distance) - lengths.begin();
+	upper = std::min(upper, lengths.size() - 1);
+	float intervalLength = lengths[upper] - lengths[upper - 1];
+	float local = intervalLength > 0.0f ? (distance - lengths[upper - 1]) / intervalLength : 0.0f;
+	return (static_cast<float>(upper - 1) + local) / samplesPerSegment;
+}
+
+void Path::appendStroke(float fraction, std::vector<glm::vec3> &strip) const
+{
+	if (lengths.size() < 2 || fraction <= 0.0f)
+		return;
+
+	float distance = std::min(fraction, 1.0f) * length();
+	float endParameter = parameterAtDistance(distance);
+	size_t lastSample = static_cast<size_t>(endParameter * samplesPerSegment);
+
+	for (size_t i = 0; i <= lastSample && i < lengths.size(); i++)
+		strip.push_back(glm::vec3(evaluate(static_cast<float>(i) / samplesPerSegment), 0.0f));
+	strip.push_back(glm::vec3(evaluate(endParameter), 0.0f));
+}
+
+void buildArcLengthTables(JobSystem &jobs, std::vector<Path> &paths, unsigned int samplesPerSegment)
+{
+	jobs.parallelFor(0, paths.size(), 16, [&paths, samplesPerSegment](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			paths[i].buildArcLengthTable(samplesPerSegment);
+	});
+}
+
+void evaluateFollowers(const Path &path, const float *distances, glm::vec2 *positions, size_t count,
+                       JobSystem *jobs)
+{
+	auto body = [&path, distances, positions](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			positions[i] = path.pointAtDistance(distances[i]);
+	};
+	if (jobs)
+		jobs->parallelFor(0, count, 1024, body);
+	else
+		body(0, count);
+}
@@ -0,0 +1,66 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm/glm.hpp>
+
+class JobSystem;
+
+// Every segment is stored as a cubic Bézier. Quadratic curves are degree
+// elevated and Catmull-Rom splines are converted on insertion, so evaluation
+// has a single code path.
+struct PathSegment
+{
+	glm::vec2 p0, p1, p2, p3;
+};
+
+// A curve made of Bézier segments with a precomputed arc-length table.
+// After buildArcLengthTable() a position at a given distance along the curve
+// is found with a binary search into the table plus one curve evaluation,
+// which gives constant speed motion without any per-frame integration.
+class Path
+{
+public:
+	void addQuadratic(const glm::vec2 &p0, const glm::vec2 &p1, const glm::vec2 &p2);
+	void addCubic(const glm::vec2 &p0, const glm::vec2 &p1, const glm::vec2 &p2, const glm::vec2 &p3);
+	// Uniform Catmull-Rom through all points. The curve passes through every
+	// point; the first and last are duplicated as end tangents unless closed.
+	void addCatmullRom(const std::vector<glm::vec2> &points, bool closed);
+
+	// Samples every segment samplesPerSegment times and stores the cumulative
+	// length at each sample. Must be called again after adding segments.
+	void buildArcLengthTable(unsigned int samplesPerSegment = 64);
+
+	size_t segmentCount() const { return segments.size(); }
+	float length() const { return lengths.empty() ? 0.0f : lengths.back(); }
+
+	// t in [0, segmentCount()], the integer part selects the segment.
+	glm::vec2 evaluate(float t) const;
+	// Curve parameter at arc length `distance`, clamped to the path.
+	float parameterAtDistance(float distance) const;
+	glm::vec2 pointAtDistance(float distance) const { return evaluate(parameterAtDistance(distance)); }
+	// fraction in [0, 1] of the total length.
+	glm::vec2 pointAtFraction(float fraction) const { return pointAtDistance(fraction * length()); }
+
+	// Appends the part of the curve from its start up to `fraction` of its
+	// length as GL_LINE_STRIP vertices, using the table samples so the
+	// stroke grows by the same length every frame.
+	void appendStroke(float fraction, std::vector<glm::vec3> &strip) const;
+
+private:
+	std::vector<PathSegment> segments;
+	std::vector<float> lengths;  // cumulative length at sample i, parameter i / samplesPerSegment
+	unsigned int samplesPerSegment = 0;
+};
+
+// Builds the arc-length tables of many paths in parallel.
+void buildArcLengthTables(JobSystem &jobs, std::vector<Path> &paths, unsigned int samplesPerSegment = 64);
+
+// Positions `count` followers at the given distances along one path.
+// Runs on the job system when one is given.
+void evaluateFollowers(const Path &path, const float *distances, glm::vec2 *positions, size_t count,
+                       JobSystem *jobs = nullptr);
+
+#endif
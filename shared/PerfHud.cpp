@@ -0,0 +1,150 @@
+#include "PerfHud.h"
+#include "AllocationTracker.h"
+#include "GlCallCounter.h"
+#include "GlResourceTracker.h"
+#include "GlyphAtlas.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+	// Sizes in pixels at 1080 lines, scaled with the framebuffer height
+	const float TEXT_SIZE = 18.0f;
+	const float MARGIN = 10.0f;
+	const float PADDING = 8.0f;
+	const float PANEL_WIDTH = 360.0f;
+	const float GRAPH_HEIGHT = 60.0f;
+	const unsigned int FONT_SIZE = 32;
+	const int TEXT_LINES = 5;
+	// The graph is at least this tall in ms, with a reference line at 60 fps
+	const float GRAPH_MIN_MS = 33.3f;
+	const float TARGET_MS = 1000.0f / 60.0f;
+
+	double steadySeconds()
+	{
+		using namespace std::chrono;
+		return duration<double>(steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+PerfHud::PerfHud()
+{
+	// Sized once so formatting a frame never allocates
+	text.reserve(512);
+	graph.reserve(2 * HISTORY);
+}
+
+void PerfHud::setVisible(bool visible)
+{
+	// Neither the frame time since the HUD was last shown nor the graph from
+	// back then says anything about the frames to come
+	if (visible && !this->visible)
+	{
+		lastFrameTime = 0.0;
+		frameCount = 0;
+	}
+	this->visible = visible;
+}
+
+void PerfHud::draw(Canvas &canvas, double cpuMs)
+{
+	PROFILE_SCOPE("PerfHud::draw");
+	double now = steadySeconds();
+	if (lastFrameTime > 0.0)
+	{
+		newest = (newest + 1) % HISTORY;
+		frameMs[newest] = static_cast<float>((now - lastFrameTime) * 1000.0);
+		frameCount = std::min(frameCount + 1, HISTORY);
+	}
+	lastFrameTime = now;
+
+	if (!fontChecked)
+	{
+		// Use the scene's font if it loaded one
+		if (canvas.fontPixelSize() == 0)
+			canvas.loadFont(HUD_FONT_PATH, FONT_SIZE);
+		fontChecked = true;
+	}
+
+	float totalMs = 0.0f, maxMs = 0.0f;
+	for (int i = 0; i < frameCount; i++)
+	{
+		totalMs += frameMs[i];
+		maxMs = std::max(maxMs, frameMs[i]);
+	}
+	float lastMs = frameCount > 0 ? frameMs[newest] : 0.0f;
+	float fps = totalMs > 0.0f ? frameCount * 1000.0f / totalMs : 0.0f;
+
+	char gpu[16] = "-", draws[16] = "-", upload[16] = "-", allocations[32] = "-", resources[32] = "-";
+#ifdef ANIM_PROFILE
+	double gpuMs = profilerLastGpuFrameMs();
+	if (gpuMs >= 0.0)
+		std::snprintf(gpu, sizeof(gpu), "%.2f ms", gpuMs);
+#endif
+	if (isGlCallCounterInstalled())
+	{
+		const GlCallStats &stats = glLastFrameStats();
+		std::snprintf(draws, sizeof(draws), "%llu", static_cast<unsigned long long>(stats.drawCalls));
+		std::snprintf(upload, sizeof(upload), "%.1f KB", stats.uploadedBytes / 1024.0);
+	}
+	if (isGlResourceTrackerInstalled())
+	{
+		const GlResourceTotals &totals = glResourceTotals();
+		std::snprintf(resources, sizeof(resources), "%llu (%.1f MB)",
+		              static_cast<unsigned long long>(totals.liveObjects), totals.liveBytes / (1024.0 * 1024.0));
+	}
+#ifdef ANIM_TRACK_ALLOCATIONS
+	const AllocationFrameStats &heap = allocationLastFrameStats();
+	std::snprintf(allocations, sizeof(allocations), "%llu (%.1f KB)",
+	              static_cast<unsigned long long>(heap.allocations), heap.bytes / 1024.0);
+#endif
+
+	char buffer[512];
+	std::snprintf(buffer, sizeof(buffer),
+	              "FPS %.1f  frame %.1f ms  max %.1f\nCPU %.2f ms  GPU %s\ndraws %s  upload %s\nallocations %s\nGL objects %s",
+	              fps, lastMs, maxMs, cpuMs, gpu, draws, upload, allocations, resources);
+	text.assign(buffer);
+
+	// Pixels to NDC, origin bottom-left like the text
+	float width = static_cast<float>(canvas.width());
+	float height = static_cast<float>(canvas.height());
+	float ui = std::max(1.0f, height / 1080.0f);
+	auto ndc = [width, height](float x, float y) { return glm::vec3(x / width * 2.0f - 1.0f, y / height * 2.0f - 1.0f, 0.0f); };
+
+	float lineHeight = GlyphAtlas::LINE_SPACING * TEXT_SIZE * ui;
+	float left = MARGIN * ui, top = height - MARGIN * ui;
+	float right = left + PANEL_WIDTH * ui;
+	float graphTop = top - PADDING * ui - TEXT_LINES * lineHeight;
+	float graphBottom = graphTop - GRAPH_HEIGHT * ui;
+	float bottom = graphBottom - PADDING * ui;
+
+	const glm::vec3 panel[6] = {
+		ndc(left, bottom), ndc(right, bottom), ndc(right, top),
+		ndc(left, bottom), ndc(right, top), ndc(left, top)
+	};
+	canvas.drawTriangles(panel, 6, glm::vec4(0.0f, 0.0f, 0.0f, 0.65f));
+
+	unsigned int fontSize = canvas.fontPixelSize();
+	if (fontSize > 0)
+		canvas.drawText(text, left + PADDING * ui, top - PADDING * ui - TEXT_SIZE * ui, TEXT_SIZE * ui / fontSize,
+		                glm::vec3(1.0f, 1.0f, 1.0f));
+
+	// Oldest frame on the left, the 60 fps line first so it shares the draw
+	float graphLeft = left + PADDING * ui, graphRight = right - PADDING * ui;
+	float msToPixels = (graphTop - graphBottom) / std::max(GRAPH_MIN_MS, maxMs);
+	float step = (graphRight - graphLeft) / (HISTORY - 1);
+	graph.clear();
+	graph.push_back(ndc(graphLeft, graphBottom + TARGET_MS * msToPixels));
+	graph.push_back(ndc(graphRight, graphBottom + TARGET_MS * msToPixels));
+	for (int i = 1; i < frameCount; i++)
+	{
+		int previous = (newest - frameCount + i + HISTORY) % HISTORY;
+		int current = (previous + 1) % HISTORY;
+		float x = graphRight - (frameCount - i) * step;
+		graph.push_back(ndc(x, graphBottom + frameMs[previous] * msToPixels));
+		graph.push_back(ndc(x + step, graphBottom + frameMs[current] * msToPixels));
+	}
+	canvas.drawLines(graph.data(), graph.size(), 1.0f, glm::vec4(0.3f, 0.9f, 0.4f, 1.0f));
+}
@@ -0,0 +1,47 @@
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <string>
+#include <vector>
+
+#include "Canvas.h"
+
+// Performance overlay in the top-left corner: FPS, a graph of the recent
+// frame times, CPU and GPU time, draw calls, uploaded bytes, heap
+// allocations and live GL objects. It only reads numbers that are collected
+// anyway: the GL call counter, the profiler's GPU queries (-DANIM_PROFILE=ON),
+// the allocation tracker (-DANIM_TRACK_ALLOCATIONS=ON) and the GL resource
+// tracker (--gl-resources); whatever is not available shows as "-".
+// The whole overlay is three canvas draws: the panel, one multi-line string
+// and one line list for the graph.
+//
+// RenderContext draws it on top of every presented frame while visible
+// (--hud, F3 in a window).
+class PerfHud
+{
+public:
+	PerfHud();
+
+	void setVisible(bool visible);
+	bool isVisible() const { return visible; }
+	void toggle() { setVisible(!visible); }
+
+	// Draws the overlay for the frame about to be presented. `cpuMs` is the
+	// time the scene spent on it before presenting.
+	void draw(Canvas &canvas, double cpuMs);
+
+private:
+	static constexpr int HISTORY = 120;
+
+	bool visible = false;
+	bool fontChecked = false;
+	double lastFrameTime = 0.0;
+	float frameMs[HISTORY] = {};
+	int frameCount = 0;
+	int newest = HISTORY - 1;
+
+	std::string text;
+	std::vector<glm::vec3> graph;
+};
+
+#endif
@@ -0,0 +1,373 @@
+#include "Profiler.h"
+
+#ifdef ANIM_PROFILE
+
+#include <glad/glad.h>
+
+#include "GlResourceTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	const size_t CHUNK_EVENTS = 4096;
+	// Frames a GPU query may take to finish before new GPU scopes are skipped
+	const int GPU_FRAME_LATENCY = 4;
+
+	// A scope lasts `duration`; a counter sample has no duration but a value
+	struct ProfileEvent
+	{
+		const char *name;
+		uint64_t start;
+		uint64_t duration;
+		double value;
+		bool counter;
+	};
+
+	// Only the owning thread appends; a reader sees every event below `count`.
+	struct EventChunk
+	{
+		ProfileEvent events[CHUNK_EVENTS];
+		std::atomic<size_t> count {0};
+		std::atomic<EventChunk*> next {nullptr};
+	};
+
+	struct ThreadBuffer
+	{
+		uint32_t id = 0;
+		std::string name;
+		EventChunk *first = nullptr;
+		EventChunk *last = nullptr;
+
+		void record(const char *eventName, uint64_t start, uint64_t duration, double value = 0.0, bool counter = false)
+		{
+			size_t index = last->count.load(std::memory_order_relaxed);
+			if (index == CHUNK_EVENTS)
+			{
+				EventChunk *chunk = new EventChunk();
+				last->next.store(chunk, std::memory_order_release);
+				last = chunk;
+				index = 0;
+			}
+			last->events[index] = { eventName, start, duration, value, counter };
+			last->count.store(index + 1, std::memory_order_release);
+		}
+	};
+
+	struct GpuQuery
+	{
+		const char *name;
+		GLuint query;
+		uint64_t cpuStart;
+	};
+
+	struct GpuFrame
+	{
+		std::vector<GpuQuery> queries;
+		bool pending = false;
+	};
+
+	struct ProfilerState
+	{
+		std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+		// Owned by the GL thread
+		uint64_t lastFrameEnd = 0;
+		bool gpuEnabled = false;
+		bool gpuScopeOpen = false;
+		ThreadBuffer *gpuTrack = nullptr;
+		GpuFrame gpuFrames[GPU_FRAME_LATENCY];
+		int currentGpuFrame = 0;
+		std::vector<GLuint> freeQueries;
+		uint64_t skippedGpuScopes = 0;
+		// GPU time of the most recent frame whose queries were read back
+		double lastGpuFrameMs = -1.0;
+
+		~ProfilerState()
+		{
+			for (std::unique_ptr<ThreadBuffer> &thread : threads)
+			{
+				EventChunk *chunk = thread->first;
+				while (chunk)
+				{
+					EventChunk *next = chunk->next.load(std::memory_order_acquire);
+					delete chunk;
+					chunk = next;
+				}
+			}
+		}
+
+		ThreadBuffer *createBuffer(const std::string &name)
+		{
+			std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+			buffer->first = buffer->last = new EventChunk();
+			buffer->name = name;
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffer->id = static_cast<uint32_t>(threads.size() + 1);
+			if (buffer->name.empty())
+				buffer->name = "thread " + std::to_string(buffer->id);
+			threads.push_back(std::move(buffer));
+			return threads.back().get();
+		}
+	};
+
+	ProfilerState &profiler()
+	{
+		static ProfilerState state;
+		return state;
+	}
+
+	ThreadBuffer &threadBuffer()
+	{
+		// Registered once per thread, every later event is lock-free
+		thread_local ThreadBuffer *buffer = profiler().createBuffer(std::string());
+		return *buffer;
+	}
+
+	// Results of one frame's queries become available in the order they were
+	// issued, so the last query being done means the whole frame is.
+	bool collectGpuFrame(ProfilerState &state, GpuFrame &frame, bool wait)
+	{
+		if (!frame.queries.empty() && !wait)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(frame.queries.back().query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return false;
+		}
+		GLuint64 total = 0;
+		for (const GpuQuery &query : frame.queries)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &elapsed);
+			state.gpuTrack->record(query.name, query.cpuStart, elapsed);
+			state.freeQueries.push_back(query.query);
+			total += elapsed;
+		}
+		if (!frame.queries.empty())
+			state.lastGpuFrameMs = total / 1e6;
+		frame.queries.clear();
+		frame.pending = false;
+		return true;
+	}
+
+	std::string escapeJson(const std::string &text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+}
+
+uint64_t profilerNow()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - profiler().epoch).count());
+}
+
+ProfileScope::ProfileScope(const char *name) : name(name), start(profilerNow())
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+	threadBuffer().record(name, start, profilerNow() - start);
+}
+
+GpuProfileScope::GpuProfileScope(const char *name) : open(false)
+{
+	ProfilerState &state = profiler();
+	if (!state.gpuEnabled || state.gpuScopeOpen)
+		return;
+
+	GpuFrame &frame = state.gpuFrames[state.currentGpuFrame];
+	if (frame.pending)
+	{
+		// The GPU is more than GPU_FRAME_LATENCY frames behind; skip rather than wait
+		state.skippedGpuScopes++;
+		return;
+	}
+
+	GLuint query;
+	if (state.freeQueries.empty())
+	{
+		GL_RESOURCE_SITE("Profiler");
+		glGenQueries(1, &query);
+	}
+	else
+	{
+		query = state.freeQueries.back();
+		state.freeQueries.pop_back();
+	}
+	frame.queries.push_back({ name, query, profilerNow() });
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	state.gpuScopeOpen = open = true;
+}
+
+GpuProfileScope::~GpuProfileScope()
+{
+	if (!open)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	profiler().gpuScopeOpen = false;
+}
+
+void profilerSetThreadName(const std::string &name)
+{
+	ThreadBuffer &buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(profiler().registryMutex);
+	buffer.name = name;
+}
+
+void profilerCounter(const char *name, double value)
+{
+	threadBuffer().record(name, profilerNow(), 0, value, true);
+}
+
+void profilerFrame()
+{
+	ProfilerState &state = profiler();
+	uint64_t now = profilerNow();
+	if (state.lastFrameEnd > 0)
+		threadBuffer().record("frame", state.lastFrameEnd, now - state.lastFrameEnd);
+	state.lastFrameEnd = now;
+
+	if (!state.gpuEnabled)
+		return;
+
+	state.gpuFrames[state.currentGpuFrame].pending = true;
+	state.currentGpuFrame = (state.currentGpuFrame + 1) % GPU_FRAME_LATENCY;
+	for (GpuFrame &frame : state.gpuFrames)
+		if (frame.pending)
+			collectGpuFrame(state, frame, false);
+}
+
+double profilerLastGpuFrameMs()
+{
+	return profiler().lastGpuFrameMs;
+}
+
+void profilerEnableGpu(bool enable)
+{
+	ProfilerState &state = profiler();
+	if (enable && !state.gpuTrack)
+		state.gpuTrack = state.createBuffer("GPU");
+	state.gpuEnabled = enable;
+}
+
+void profilerShutdownGpu()
+{
+	ProfilerState &state = profiler();
+	if (!state.gpuTrack)
+		return;
+
+	for (GpuFrame &frame : state.gpuFrames)
+		collectGpuFrame(state, frame, true);
+	if (!state.freeQueries.empty())
+		glDeleteQueries(static_cast<GLsizei>(state.freeQueries.size()), state.freeQueries.data());
+	state.freeQueries.clear();
+	state.gpuEnabled = false;
+
+	if (state.skippedGpuScopes > 0)
+		std::cout << "Profiler skipped " << state.skippedGpuScopes << " GPU scopes while waiting on queries" << std::endl;
+}
+
+bool profilerWrite(const std::string &path)
+{
+	struct ThreadEvents
+	{
+		uint32_t id;
+		std::string name;
+		std::vector<ProfileEvent> events;
+	};
+
+	std::vector<ThreadEvents> threads;
+	size_t eventCount = 0;
+	{
+		ProfilerState &state = profiler();
+		std::lock_guard<std::mutex> lock(state.registryMutex);
+		for (const std::unique_ptr<ThreadBuffer> &buffer : state.threads)
+		{
+			ThreadEvents thread { buffer->id, buffer->name, {} };
+			for (EventChunk *chunk = buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+			{
+				size_t count = chunk->count.load(std::memory_order_acquire);
+				thread.events.insert(thread.events.end(), chunk->events, chunk->events + count);
+			}
+			std::sort(thread.events.begin(), thread.events.end(),
+			          [](const ProfileEvent &a, const ProfileEvent &b) { return a.start < b.start; });
+			eventCount += thread.events.size();
+			threads.push_back(std::move(thread));
+		}
+	}
+
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "ERROR::PROFILER: Failed to open " << path << std::endl;
+		return false;
+	}
+	out << std::fixed << std::setprecision(3);
+
+	bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+	if (csv)
+	{
+		out << "thread,name,start_us,duration_us,value\n";
+		for (const ThreadEvents &thread : threads)
+			for (const ProfileEvent &event : thread.events)
+			{
+				out << thread.name << ',' << event.name << ',' << event.start / 1000.0 << ',';
+				if (event.counter)
+					out << ',' << event.value << '\n';
+				else
+					out << event.duration / 1000.0 << ",\n";
+			}
+	}
+	else
+	{
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (const ThreadEvents &thread : threads)
+		{
+			out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id
+			    << ",\"args\":{\"name\":\"" << escapeJson(thread.name) << "\"}}";
+			first = false;
+			for (const ProfileEvent &event : thread.events)
+			{
+				out << ",\n{\"name\":\"" << escapeJson(event.name) << "\",\"pid\":1,\"tid\":" << thread.id
+				    << ",\"ts\":" << event.start / 1000.0;
+				if (event.counter)
+					out << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+				else
+					out << ",\"ph\":\"X\",\"dur\":" << event.duration / 1000.0 << '}';
+			}
+		}
+		out << "\n]}\n";
+	}
+
+	if (!out)
+	{
+		std::cout << "ERROR::PROFILER: Failed to write " << path << std::endl;
+		return false;
+	}
+	std::cout << "Wrote " << eventCount << " profile events to " << path << std::endl;
+	return true;
+}
+
+#endif
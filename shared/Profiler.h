@@ -0,0 +1,92 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Frame-time instrumentation. Configure with -DANIM_PROFILE=ON to compile it
+// in; otherwise every macro below expands to nothing and costs nothing.
+//
+//   PROFILE_SCOPE("loadScene");        CPU time until the end of the block
+//   PROFILE_GPU_SCOPE("draw");         GPU time of the GL commands in the block
+//   PROFILE_THREAD_NAME("encoder");    names the calling thread in the trace
+//   PROFILE_FRAME();                   marks the end of a frame
+//   PROFILE_COUNTER("draws", value);   samples a value, drawn as a graph
+//
+// Scope names must be string literals, only the pointer is stored. Every
+// thread records into its own chunked buffer that only it appends to, so
+// recording takes no lock. GPU scopes use GL_TIME_ELAPSED queries whose
+// results are read a few frames later, once available, so the pipeline never
+// stalls on them. Those queries cannot nest: a GPU scope opened inside
+// another one is ignored.
+//
+// Run a scene with --profile trace.json to write a Chrome trace (open it in
+// chrome://tracing or ui.perfetto.dev), or --profile trace.csv for CSV.
+
+#ifdef ANIM_PROFILE
+
+#include <cstdint>
+#include <string>
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char *name);
+	~ProfileScope();
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char *name;
+	uint64_t start;
+};
+
+class GpuProfileScope
+{
+public:
+	explicit GpuProfileScope(const char *name);
+	~GpuProfileScope();
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+	bool open;
+};
+
+// Nanoseconds since the profiler started.
+uint64_t profilerNow();
+void profilerSetThreadName(const std::string &name);
+void profilerCounter(const char *name, double value);
+// Called once per frame on the GL thread. Records the frame span and reads
+// back the GPU queries that have finished.
+void profilerFrame();
+// Summed GPU scopes of the latest frame whose queries have been read back,
+// a few frames old; negative until there is one.
+double profilerLastGpuFrameMs();
+// GPU scopes are only recorded while enabled; needs a current GL context.
+void profilerEnableGpu(bool enable);
+// Waits for the outstanding GPU queries and deletes them. Call before the
+// GL context goes away.
+void profilerShutdownGpu();
+// Writes everything recorded so far, as CSV if `path` ends in .csv and as a
+// Chrome trace otherwise.
+bool profilerWrite(const std::string &path);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) profilerSetThreadName(name)
+#define PROFILE_FRAME() profilerFrame()
+#define PROFILE_COUNTER(name, value) profilerCounter(name, value)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,358 @@
+#include "ProgramCache.h"
+#include "FrameUniforms.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+// ARB_get_program_binary, core in GL 4.1
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace {
+	typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+	typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+	const char CACHE_MAGIC[8] = { 'A', 'N', 'I', 'M', 'P', 'R', 'O', 'G' };
+	const uint32_t CACHE_VERSION = 1;
+
+	struct CacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		GLenum format;
+		uint64_t key;
+		uint64_t length;
+	};
+
+	GetProgramBinaryProc getProgramBinary = nullptr;
+	ProgramBinaryProc programBinary = nullptr;
+	ProgramParameteriProc programParameteri = nullptr;
+	bool enabled = false;
+	std::string cacheDirectory;
+	std::string driverIdentity;
+	ProgramCacheStats stats;
+
+	double steadyMs()
+	{
+		using namespace std::chrono;
+		return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	// FNV-1a, continued from `hash`
+	uint64_t hashBytes(uint64_t hash, const std::string &bytes)
+	{
+		for (unsigned char c : bytes)
+		{
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		// Keeps "ab" + "c" apart from "a" + "bc"
+		hash ^= 0xff;
+		return hash * 1099511628211ull;
+	}
+
+	const char *glString(GLenum name)
+	{
+		const GLubyte *value = glGetString(name);
+		return value ? reinterpret_cast<const char*>(value) : "";
+	}
+
+	std::string withDefines(const char *source, const std::string &defines)
+	{
+		std::string text = source;
+		if (defines.empty())
+			return text;
+		// Nothing but comments may come before #version
+		size_t insertAt = 0;
+		size_t version = text.find("#version");
+		if (version != std::string::npos)
+		{
+			size_t lineEnd = text.find('\n', version);
+			if (lineEnd == std::string::npos)
+			{
+				text += '\n';
+				lineEnd = text.size() - 1;
+			}
+			insertAt = lineEnd + 1;
+		}
+		text.insert(insertAt, defines.back() == '\n' ? defines : defines + '\n');
+		return text;
+	}
+
+	// Driver logs start every message with a source string and a line:
+	// "0:12(5): error: ..." (Mesa), "0(12) : error ..." (NVIDIA) or
+	// "ERROR: 0:12: ..." (AMD). Rewritten to "name:12:5: error: ..." so the
+	// location reads like a compiler's and editors can jump to it.
+	std::string formatInfoLog(const char *name, const char *log)
+	{
+		std::istringstream lines(log);
+		std::string line, formatted;
+		while (std::getline(lines, line))
+		{
+			const char *text = line.c_str();
+			const char *severity = "";
+			if (std::strncmp(text, "ERROR: ", 7) == 0)
+			{
+				severity = "error: ";
+				text += 7;
+			}
+			unsigned int source = 0, lineNumber = 0, column = 0;
+			int consumed = 0;
+			bool located = std::sscanf(text, "%u:%u%n", &source, &lineNumber, &consumed) == 2
+			               || std::sscanf(text, "%u(%u)%n", &source, &lineNumber, &consumed) == 2;
+			if (!located)
+			{
+				formatted += line + "\n";
+				continue;
+			}
+			text += consumed;
+			int columnLength = 0;
+			if (std::sscanf(text, "(%u)%n", &column, &columnLength) == 1)
+				text += columnLength;
+			while (*text == ' ' || *text == ':')
+				text++;
+			formatted += std::string(name) + ":" + std::to_string(lineNumber);
+			if (column > 0)
+				formatted += ":" + std::to_string(column);
+			formatted += std::string(": ") + severity + text + "\n";
+		}
+		return formatted;
+	}
+
+	GLuint compileStage(GLenum type, const std::string &source, const char *name)
+	{
+		GLuint shader = glCreateShader(type);
+		const char *text = source.c_str();
+		glShaderSource(shader, 1, &text, nullptr);
+		glCompileShader(shader);
+
+		GLint success;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			GLchar infoLog[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "ERROR::SHADER: Failed to compile the " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
+			          << " shader of " << name << "\n" << formatInfoLog(name, infoLog) << std::flush;
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+
+	GLuint buildProgram(const char *name, const std::string &vertexSource, const std::string &fragmentSource, bool retrievable)
+	{
+		GLuint vertexShader = compileStage(GL_VERTEX_SHADER, vertexSource, name);
+		GLuint fragmentShader = compileStage(GL_FRAGMENT_SHADER, fragmentSource, name);
+		if (!vertexShader || !fragmentShader)
+		{
+			glDeleteShader(vertexShader);
+			glDeleteShader(fragmentShader);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		if (retrievable && programParameteri)
+			programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		GLint success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			GLchar infoLog[1024];
+			glGetProgramInfoLog(program, 1024, NULL, infoLog);
+			std::cout << "ERROR::SHADER: Failed to link " << name << "\n" << formatInfoLog(name, infoLog) << std::flush;
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	// 0 if there is no usable binary; `rejected` tells a refused one from a missing one
+	GLuint loadBinary(const std::string &path, uint64_t key, bool &rejected)
+	{
+		rejected = false;
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return 0;
+		CacheHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+		    || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+		    || header.version != CACHE_VERSION || header.key != key || header.length == 0 || header.length > (1u << 30))
+		{
+			rejected = true;
+			return 0;
+		}
+		std::vector<char> binary(header.length);
+		if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+		{
+			rejected = true;
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		programBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			// An unknown format raises GL_INVALID_ENUM, which is no concern of the scene
+			while (glGetError() != GL_NO_ERROR)
+				;
+			glDeleteProgram(program);
+			rejected = true;
+			return 0;
+		}
+		return program;
+	}
+
+	void storeBinary(const std::string &path, uint64_t key, GLuint program)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+			return;
+		CacheHeader header;
+		std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.version = CACHE_VERSION;
+		header.key = key;
+		std::vector<char> binary(static_cast<size_t>(length));
+		GLsizei written = 0;
+		getProgramBinary(program, length, &written, &header.format, binary.data());
+		if (written <= 0)
+			return;
+		header.length = static_cast<uint64_t>(written);
+
+		// Worker processes may store the same program at once; each renames its own complete file
+		std::string temporary = path + ".tmp" + std::to_string(getpid());
+		{
+			std::ofstream out(temporary, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(binary.data(), written);
+			if (!out)
+			{
+				std::cout << "ERROR::PROGRAM_CACHE: Failed to write " << temporary << ", caching disabled" << std::endl;
+				enabled = false;
+				out.close();
+				std::remove(temporary.c_str());
+				return;
+			}
+		}
+		if (std::rename(temporary.c_str(), path.c_str()) != 0)
+			std::remove(temporary.c_str());
+	}
+}
+
+void programCacheInit(GLADloadproc loader, const std::string &directory)
+{
+	enabled = false;
+	getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(loader("glGetProgramBinary"));
+	programBinary = reinterpret_cast<ProgramBinaryProc>(loader("glProgramBinary"));
+	programParameteri = reinterpret_cast<ProgramParameteriProc>(loader("glProgramParameteri"));
+	if (directory.empty() || !getProgramBinary || !programBinary)
+		return;
+
+	// Not a valid query without program binaries; the count then stays 0
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	while (glGetError() != GL_NO_ERROR)
+		;
+	if (formats <= 0)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		std::cout << "ERROR::PROGRAM_CACHE: Failed to create " << directory << ": " << error.message() << std::endl;
+		return;
+	}
+	cacheDirectory = directory;
+	driverIdentity = std::string(glString(GL_VENDOR)) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION)
+	                 + '\n' + glString(GL_SHADING_LANGUAGE_VERSION);
+	enabled = true;
+}
+
+std::string defaultProgramCacheDirectory()
+{
+	const char *directory = std::getenv("ANIM_SHADER_CACHE");
+	if (directory && *directory)
+		return directory;
+	const char *cacheHome = std::getenv("XDG_CACHE_HOME");
+	if (cacheHome && *cacheHome)
+		return std::string(cacheHome) + "/animations/programs";
+	const char *home = std::getenv("HOME");
+	if (home && *home)
+		return std::string(home) + "/.cache/animations/programs";
+	return std::string();
+}
+
+GLuint loadProgram(const char *name, const char *vertexSource, const char *fragmentSource, const std::string &defines)
+{
+	PROFILE_SCOPE("loadProgram");
+	double start = steadyMs();
+	std::string vertex = withDefines(vertexSource, defines);
+	std::string fragment = withDefines(fragmentSource, defines);
+
+	GLuint program = 0;
+	if (!enabled)
+	{
+		program = buildProgram(name, vertex, fragment, false);
+		stats.uncached++;
+	}
+	else
+	{
+		uint64_t key = hashBytes(hashBytes(hashBytes(14695981039346656037ull, driverIdentity), vertex), fragment);
+		char fileName[32];
+		std::snprintf(fileName, sizeof(fileName), "%016llx.bin", static_cast<unsigned long long>(key));
+		std::string path = cacheDirectory + "/" + fileName;
+
+		bool rejected = false;
+		program = loadBinary(path, key, rejected);
+		if (program)
+			stats.hits++;
+		else
+		{
+			program = buildProgram(name, vertex, fragment, true);
+			if (program)
+				storeBinary(path, key, program);
+			if (rejected)
+				stats.rejected++;
+			else
+				stats.misses++;
+		}
+	}
+	// Block bindings are link state, a loaded binary starts without them too
+	if (program)
+		bindFrameUniformBlock(program);
+	stats.loadMs += steadyMs() - start;
+	return program;
+}
+
+const ProgramCacheStats &programCacheStats()
+{
+	return stats;
+}
@@ -0,0 +1,46 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+// Links GL programs from GLSL source and keeps the linked binaries on disk,
+// so later runs skip compiling and linking. A program is stored under a hash
+// of its sources, its defines and the driver (GL vendor, renderer and
+// version strings); a driver update or a changed shader simply misses. A
+// binary the driver rejects is compiled again and replaced.
+//
+// The cache directory is --shader-cache <dir>, else $ANIM_SHADER_CACHE, else
+// $XDG_CACHE_HOME/animations/programs or ~/.cache/animations/programs;
+// --no-shader-cache always compiles. Drivers without program binary formats
+// always compile too.
+
+struct ProgramCacheStats
+{
+	uint64_t hits = 0;     // loaded from a binary
+	uint64_t misses = 0;   // compiled, binary stored
+	uint64_t rejected = 0; // binary on disk refused by the driver, compiled again
+	uint64_t uncached = 0; // compiled without the cache
+	double loadMs = 0.0;   // total time spent in loadProgram
+};
+
+// Called by RenderContext once the context is current. `loader` resolves the
+// program binary entry points, which the GL 3.3 glad loader does not load.
+// An empty `directory` disables the cache.
+void programCacheInit(GLADloadproc loader, const std::string &directory);
+// Where the cache lives when no directory is given on the command line
+std::string defaultProgramCacheDirectory();
+
+// Compiles and links `vertexSource` and `fragmentSource`, or loads the
+// program from the cache. `defines` (e.g. "#define SAMPLES 4\n") is inserted
+// after the #version line of both stages. A FrameUniforms block
+// (FrameUniforms.h) is bound to its binding point. Returns 0 and prints the
+// info log if the program does not build, with locations as "name:line:column".
+GLuint loadProgram(const char *name, const char *vertexSource, const char *fragmentSource,
+                   const std::string &defines = std::string());
+
+const ProgramCacheStats &programCacheStats();
+
+#endif
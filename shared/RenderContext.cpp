@@ -0,0 +1,609 @@
+#include "RenderContext.h"
+#include "AllocationTracker.h"
+#include "GlfwWindowUtils.h"
+#include "FrameRange.h"
+#include "GlCallCounter.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+#include "GlCanvas.h"
+#include "Profiler.h"
+#include "SoftCanvas.h"
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+	const long DEFAULT_HEADLESS_FRAMES = 600;
+	const double DEFAULT_EXPORT_FPS = 60.0;
+	// Frames that may still allocate under --alloc-budget: caches, pools and
+	// lazily created GL objects fill up during the first ones
+	const long ALLOC_WARMUP_FRAMES = 3;
+
+	// Encoding (PNG, Y4M conversion) runs on these, leave the rest to rendering.
+	// Sized from --threads so range workers split the cores instead of each taking half.
+	unsigned int encoderThreads(const RenderOptions &options)
+	{
+		unsigned int threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+		return std::max(1u, threads / 2);
+	}
+
+	double steadySeconds()
+	{
+		using namespace std::chrono;
+		return duration<double>(steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+RenderOptions parseRenderOptions(int argc, char const *argv[])
+{
+	RenderOptions options;
+	const char *headlessEnv = std::getenv("ANIM_HEADLESS");
+	options.headless = headlessEnv && std::strcmp(headlessEnv, "0") != 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--headless")
+			options.headless = true;
+		else if (arg == "--software")
+			options.software = options.headless = true;
+		else if (arg == "--threads" && hasValue)
+			options.threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+		else if (arg == "--frames" && hasValue)
+			options.frames = std::atol(argv[++i]);
+		else if (arg == "--samples" && hasValue)
+			options.samples = std::atoi(argv[++i]);
+		else if (arg == "--export" && hasValue)
+			options.exportPath = argv[++i];
+		else if (arg == "--fps" && hasValue)
+			options.fps = std::atof(argv[++i]);
+		else if (arg == "--gl-stats")
+			options.glStats = true;
+		else if (arg == "--gl-resources")
+			options.glResources = true;
+		else if (arg == "--shader-cache" && hasValue)
+			options.shaderCachePath = argv[++i];
+		else if (arg == "--no-shader-cache")
+			options.shaderCache = false;
+		else if (arg == "--hud")
+			options.hud = true;
+		else if (arg == "--profile" && hasValue)
+			options.profilePath = argv[++i];
+		else if (arg == "--frame-stats" && hasValue)
+			options.frameStatsPath = argv[++i];
+		else if (arg == "--alloc-stats")
+			options.allocStats = true;
+		else if (arg == "--alloc-budget" && hasValue)
+			options.allocBudget = std::atol(argv[++i]);
+		else if (arg == "--workers" && hasValue)
+			options.workers = std::atoi(argv[++i]);
+		else if (arg == "--range" && hasValue)
+		{
+			long first = 0, last = 0;
+			if (std::sscanf(argv[++i], "%ld:%ld", &first, &last) == 2 && last > first)
+			{
+				options.startFrame = first;
+				options.frames = last - first;
+			}
+		}
+		else if (arg == "--size" && hasValue)
+			std::sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+		else
+			options.positional.push_back(arg);
+	}
+	return options;
+}
+
+RenderContext::~RenderContext()
+{
+	destroy();
+}
+
+bool RenderContext::create(int argc, char const *argv[], const char *title, int width, int height)
+{
+	double createTime = steadySeconds();
+	options = parseRenderOptions(argc, argv);
+	if (options.workers > 1)
+	{
+		// Coordinator: this process only spawns the workers and never opens a context
+		std::exit(runFrameRangeWorkers(argc, argv, options));
+	}
+	PROFILE_THREAD_NAME("main");
+	ALLOC_THREAD_NAME("main");
+#ifndef ANIM_PROFILE
+	if (!options.profilePath.empty())
+		std::cout << "ERROR::PROFILER: --profile needs a build configured with -DANIM_PROFILE=ON" << std::endl;
+#endif
+#ifdef ANIM_TRACK_ALLOCATIONS
+	allocationSetFrameBudget(options.allocBudget, ALLOC_WARMUP_FRAMES);
+#else
+	if (options.allocStats || options.allocBudget >= 0)
+		std::cout << "ERROR::ALLOC: --alloc-stats and --alloc-budget need a build configured with -DANIM_TRACK_ALLOCATIONS=ON" << std::endl;
+#endif
+	if (options.fps <= 0.0 && (options.startFrame > 0 || !options.exportPath.empty()))
+		options.fps = DEFAULT_EXPORT_FPS;
+
+	framebufferWidth = options.width > 0 ? options.width : width;
+	framebufferHeight = options.height > 0 ? options.height : height;
+	if (options.headless && options.frames < 0)
+		options.frames = DEFAULT_HEADLESS_FRAMES;
+	perfHud.setVisible(options.hud);
+
+	if (options.software)
+	{
+		// No GL at all, frames are handed to the exporter straight from the canvas
+		if (!options.exportPath.empty())
+			exporter.start(framebufferWidth, framebufferHeight, options.startFrame,
+			               createFrameSink(options.exportPath, options.fps), 0, encoderThreads(options));
+		frame = options.startFrame;
+		restartClock();
+		if (!options.frameStatsPath.empty())
+			frameStats.start(createTime, false);
+		frameStartTime = steadySeconds();
+		return true;
+	}
+
+	bool created = options.headless ? createHeadless() : createWindow(title);
+	// Installed first so the offscreen targets are tracked and the call counter wraps it
+	if (created && options.glResources)
+		installGlResourceTracker();
+	if (created && options.headless)
+		created = createOffscreenTargets();
+	if (created)
+	{
+		std::string cachePath = options.shaderCachePath.empty() ? defaultProgramCacheDirectory() : options.shaderCachePath;
+		programCacheInit(glfwWindow ? (GLADloadproc)glfwGetProcAddress : (GLADloadproc)eglGetProcAddress,
+		                 options.shaderCache ? cachePath : std::string());
+		frameUniformBuffer.create();
+	}
+	if (!created)
+	{
+		destroy();
+		return false;
+	}
+
+	glViewport(0, 0, framebufferWidth, framebufferHeight);
+#ifdef ANIM_PROFILE
+	profilerEnableGpu(!options.profilePath.empty());
+	// The trace gets the per-frame call counts as counters
+	if (!options.profilePath.empty())
+		options.glStats = true;
+#endif
+	// Frame stats report the GL objects the call counter sees
+	if (options.glStats || !options.frameStatsPath.empty())
+		installGlCallCounter();
+	if (!options.exportPath.empty())
+		exporter.start(framebufferWidth, framebufferHeight, options.startFrame,
+		               createFrameSink(options.exportPath, options.fps), 3, encoderThreads(options));
+	frame = options.startFrame;
+	restartClock();
+	updateFrameUniforms();
+	if (!options.frameStatsPath.empty())
+		frameStats.start(createTime, true);
+	frameStartTime = steadySeconds();
+	return true;
+}
+
+bool RenderContext::createWindow(const char *title)
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_SAMPLES, options.samples);
+
+	glfwWindow = glfwCreateWindow(framebufferWidth, framebufferHeight, title, NULL, NULL);
+	if (glfwWindow == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		// destroy() only terminates GLFW along with a window
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(glfwWindow);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+	glfwSetFramebufferSizeCallback(glfwWindow, framebuffer_size_callback);
+	return true;
+}
+
+bool RenderContext::createHeadless()
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+	EGLint major, minor;
+	bool surfaceless = display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor);
+	if (!surfaceless)
+	{
+		// No surfaceless platform, use the default display with a pbuffer surface
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+		{
+			std::cout << "ERROR::EGL: Failed to initialize a display" << std::endl;
+			return false;
+		}
+	}
+	eglDisplay = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "ERROR::EGL: Desktop OpenGL is not supported" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config = NULL;
+	EGLint configCount = 0;
+	eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+	if (configCount == 0)
+	{
+		// Mesa's surfaceless platform exposes no configs, contexts are created without one
+		if (!surfaceless)
+		{
+			std::cout << "ERROR::EGL: No pbuffer config available" << std::endl;
+			return false;
+		}
+		config = NULL;
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "ERROR::EGL: Failed to create a GL 3.3 core context (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+		return false;
+	}
+	eglContext = context;
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!surfaceless)
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+		if (surface == EGL_NO_SURFACE)
+		{
+			std::cout << "ERROR::EGL: Failed to create a pbuffer surface" << std::endl;
+			return false;
+		}
+		eglSurface = surface;
+	}
+
+	if (!eglMakeCurrent(display, surface, surface, context))
+	{
+		std::cout << "ERROR::EGL: Failed to make the context current" << std::endl;
+		return false;
+	}
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool RenderContext::createOffscreenTargets()
+{
+	GL_RESOURCE_SITE("RenderContext");
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	int samples = std::min(options.samples, static_cast<int>(maxSamples));
+
+	glGenRenderbuffers(1, &resolveRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, resolveRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, framebufferWidth, framebufferHeight);
+	glGenFramebuffers(1, &headlessResolveFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, headlessResolveFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRenderbuffer);
+
+	if (samples > 1)
+	{
+		glGenRenderbuffers(1, &colorRenderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, framebufferWidth, framebufferHeight);
+		glGenFramebuffers(1, &headlessDrawFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, headlessDrawFBO);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRenderbuffer);
+	}
+	else
+	{
+		headlessDrawFBO = headlessResolveFBO;
+	}
+
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	if (samples > 1)
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, framebufferWidth, framebufferHeight);
+	else
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, framebufferWidth, framebufferHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::FRAMEBUFFER: Offscreen framebuffer is not complete" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void RenderContext::destroy()
+{
+	if (frameStats.isActive())
+		frameStats.finish(options.frameStatsPath);
+	if (isGlCallCounterInstalled())
+	{
+		// The HUD installs the counter too, the report is only asked for by --gl-stats
+		if (options.glStats)
+			printGlCallReport();
+		uninstallGlCallCounter();
+	}
+	exporter.finish();
+	// The GL canvas owns GL objects, release it while the context is still current
+	sceneCanvas.reset();
+	shaderLibrary.reset();
+	frameUniformBuffer.release();
+	jobSystem.reset();
+#ifdef ANIM_PROFILE
+	if (eglContext || glfwWindow)
+		profilerShutdownGpu();
+	if (!options.profilePath.empty())
+	{
+		profilerWrite(options.profilePath);
+		options.profilePath.clear();
+	}
+#endif
+#ifdef ANIM_TRACK_ALLOCATIONS
+	if (options.allocStats)
+	{
+		printAllocationReport();
+		options.allocStats = false;
+	}
+#endif
+
+	if (eglContext && headlessResolveFBO)
+	{
+		if (headlessDrawFBO != headlessResolveFBO)
+			glDeleteFramebuffers(1, &headlessDrawFBO);
+		glDeleteFramebuffers(1, &headlessResolveFBO);
+		glDeleteRenderbuffers(1, &colorRenderbuffer);
+		glDeleteRenderbuffers(1, &depthRenderbuffer);
+		glDeleteRenderbuffers(1, &resolveRenderbuffer);
+	}
+	if (isGlResourceTrackerInstalled())
+	{
+		// Whatever the context itself owns is gone, anything still alive leaked
+		printGlResourceReport();
+		uninstallGlResourceTracker();
+	}
+
+	if (eglDisplay)
+	{
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (eglSurface)
+			eglDestroySurface(eglDisplay, eglSurface);
+		if (eglContext)
+			eglDestroyContext(eglDisplay, eglContext);
+		eglTerminate(eglDisplay);
+	}
+	eglDisplay = eglContext = eglSurface = nullptr;
+	headlessDrawFBO = headlessResolveFBO = 0;
+	colorRenderbuffer = depthRenderbuffer = resolveRenderbuffer = 0;
+
+	if (glfwWindow)
+	{
+		glfwDestroyWindow(glfwWindow);
+		glfwTerminate();
+		glfwWindow = nullptr;
+	}
+}
+
+bool RenderContext::overAllocationBudget() const
+{
+#ifdef ANIM_TRACK_ALLOCATIONS
+	return options.allocBudget >= 0 && allocationBudgetExceeded();
+#else
+	return false;
+#endif
+}
+
+bool RenderContext::shouldClose() const
+{
+	if (options.frames >= 0 && frame >= options.startFrame + options.frames)
+		return true;
+	return glfwWindow && glfwWindowShouldClose(glfwWindow);
+}
+
+Canvas &RenderContext::canvas()
+{
+	if (!sceneCanvas)
+	{
+		if (options.software)
+			sceneCanvas = std::make_unique<SoftCanvas>(framebufferWidth, framebufferHeight, &jobs());
+		else
+			sceneCanvas = std::make_unique<GlCanvas>(framebufferWidth, framebufferHeight);
+	}
+	return *sceneCanvas;
+}
+
+ShaderLibrary &RenderContext::shaders()
+{
+	if (!shaderLibrary)
+		shaderLibrary = std::make_unique<ShaderLibrary>();
+	return *shaderLibrary;
+}
+
+JobSystem &RenderContext::jobs()
+{
+	if (!jobSystem)
+		jobSystem = std::make_unique<JobSystem>(options.threads);
+	return *jobSystem;
+}
+
+bool RenderContext::holdFrame()
+{
+	// The first frame of a run has nothing to repeat, and a window showing the
+	// HUD draws new numbers over the scene every frame
+	if (frame == options.startFrame || (!options.headless && perfHud.isVisible()))
+		return false;
+	frameHeld = true;
+	return options.headless;
+}
+
+void RenderContext::swapBuffers()
+{
+	PROFILE_SCOPE("RenderContext::swapBuffers");
+	double cpuMs = (steadySeconds() - frameStartTime) * 1000.0;
+	bool repeated = frameHeld;
+	frameHeld = false;
+	if (repeated)
+		exporter.repeat(frame);
+	else if (perfHud.isVisible())
+		drawHud(cpuMs);
+
+	if (options.software)
+	{
+		if (!repeated)
+		{
+			SoftCanvas &softCanvas = static_cast<SoftCanvas&>(canvas());
+			softCanvas.flush();
+			// Rasterizing is the CPU's job here, so the frame's CPU time runs until the flush is done
+			cpuMs = (steadySeconds() - frameStartTime) * 1000.0;
+			if (exporter.isActive())
+			{
+				// Hand the finished color buffer over and render the next frame into a pooled one
+				Frame captured = exporter.acquireFrame(frame);
+				softCanvas.swapPixels(captured.pixels);
+				exporter.submit(std::move(captured));
+			}
+		}
+	}
+	else if (options.headless)
+	{
+		if (!repeated)
+		{
+			PROFILE_GPU_SCOPE("present");
+			if (headlessDrawFBO != headlessResolveFBO)
+			{
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, headlessDrawFBO);
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, headlessResolveFBO);
+				glBlitFramebuffer(0, 0, framebufferWidth, framebufferHeight,
+				                  0, 0, framebufferWidth, framebufferHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			}
+			exporter.capture(headlessResolveFBO, frame);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, headlessDrawFBO);
+	}
+	else
+	{
+		if (!repeated)
+			exporter.capture(0, frame);
+		{
+			PROFILE_SCOPE("glfwSwapBuffers");
+			glfwSwapBuffers(glfwWindow);
+		}
+		glfwPollEvents();
+		glfwGetFramebufferSize(glfwWindow, &framebufferWidth, &framebufferHeight);
+
+		bool hudKey = glfwGetKey(glfwWindow, GLFW_KEY_F3) == GLFW_PRESS;
+		if (hudKey && !hudKeyDown)
+			perfHud.toggle();
+		hudKeyDown = hudKey;
+	}
+	frame++;
+	if (isGlCallCounterInstalled())
+		glCallCounterFrame();
+	if (isGlResourceTrackerInstalled())
+		glResourceTrackerFrame();
+#ifdef ANIM_TRACK_ALLOCATIONS
+	allocationTrackerFrame(frame - 1 - options.startFrame);
+#endif
+	PROFILE_FRAME();
+	// Edited shader files are swapped in before the next frame is drawn
+	if (shaderLibrary)
+		shaderLibrary->reload();
+	if (!options.software)
+		updateFrameUniforms();
+	frameStartTime = steadySeconds();
+	if (frameStats.isActive())
+	{
+		frameStats.endFrame(cpuMs, frameStartTime);
+		frameStats.beginFrame();
+	}
+}
+
+void RenderContext::updateFrameUniforms()
+{
+	PROFILE_SCOPE("RenderContext::updateFrameUniforms");
+	frameUniformBuffer.update(framebufferWidth, framebufferHeight, time(), frame);
+}
+
+void RenderContext::drawHud(double cpuMs)
+{
+	if (options.software)
+	{
+		perfHud.draw(canvas(), cpuMs);
+		return;
+	}
+
+	// Draw calls and uploads come from the call counter, GPU time from the profiler's queries
+	if (!isGlCallCounterInstalled())
+		installGlCallCounter();
+#ifdef ANIM_PROFILE
+	profilerEnableGpu(true);
+#endif
+	GLint blend[4];
+	glGetIntegerv(GL_BLEND_SRC_RGB, &blend[0]);
+	glGetIntegerv(GL_BLEND_DST_RGB, &blend[1]);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend[2]);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &blend[3]);
+	GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, headlessDrawFBO);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	perfHud.draw(canvas(), cpuMs);
+
+	glBlendFuncSeparate(blend[0], blend[1], blend[2], blend[3]);
+	if (!blendEnabled)
+		glDisable(GL_BLEND);
+}
+
+double RenderContext::time() const
+{
+	if (options.fps > 0.0)
+		return frame / options.fps;
+	if (glfwWindow)
+		return glfwGetTime() - startTime;
+	return steadySeconds() - startTime;
+}
+
+void RenderContext::restartClock()
+{
+	startTime = glfwWindow ? glfwGetTime() : steadySeconds();
+}
@@ -0,0 +1,173 @@
+#ifndef RENDER_CONTEXT_H
+#define RENDER_CONTEXT_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Canvas.h"
+#include "FrameExporter.h"
+#include "FrameStats.h"
+#include "FrameUniforms.h"
+#include "JobSystem.h"
+#include "PerfHud.h"
+#include "ShaderLibrary.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Run options shared by every scene. Parsed from the command line:
+//
+//   --headless        render offscreen through EGL, no window or display needed
+//                     (also enabled by setting ANIM_HEADLESS=1)
+//   --software        render on the CPU without any GL context (implies --headless);
+//                     scenes must draw through canvas()
+//   --threads <n>     job system threads, used by the software rasterizer (default: all cores)
+//   --frames <n>      stop after n frames (headless default: 600)
+//   --size <w>x<h>    framebuffer size (default: the size the scene asks for)
+//   --samples <n>     MSAA samples (default: 8)
+//   --export <dir>    write every presented frame to <dir>
+//   --fps <f>         deterministic clock: frame n is rendered at time n / f
+//                     (default 60 when exporting or rendering a range)
+//   --range <a>:<b>   render frames [a, b) only, seeking straight to frame a
+//   --workers <n>     split the frame range across n headless worker processes
+//   --gl-stats        count GL calls per frame and print a report at exit
+//   --gl-resources    track live GL objects and their bytes, warn when they keep
+//                     growing and list the ones never deleted at exit
+//   --shader-cache <dir>
+//                     keep linked program binaries in <dir> (default:
+//                     $ANIM_SHADER_CACHE or ~/.cache/animations/programs)
+//   --no-shader-cache compile every program from source
+//   --hud             show the performance overlay (F3 toggles it in a window)
+//   --frame-stats <file>
+//                     write per-frame CPU/GPU times, startup time, peak memory
+//                     and GL object counts as JSON when the run ends
+//   --profile <file>  write a frame profile when the run ends, a Chrome trace
+//                     or CSV if <file> ends in .csv (needs -DANIM_PROFILE=ON)
+//   --alloc-stats     count heap allocations per frame and print a report at exit
+//   --alloc-budget <n>
+//                     exit with 1 if a frame after the first few allocates more
+//                     than n times on the render thread (both need
+//                     -DANIM_TRACK_ALLOCATIONS=ON)
+//
+// Arguments that are not options are kept in `positional`.
+struct RenderOptions
+{
+	bool headless = false;
+	bool software = false;
+	bool glStats = false;
+	bool glResources = false;
+	bool hud = false;
+	bool shaderCache = true;
+	bool allocStats = false;
+	long allocBudget = -1;
+	unsigned int threads = 0;
+	long frames = -1;
+	long startFrame = 0;
+	double fps = 0.0;
+	int workers = 1;
+	int width = 0;
+	int height = 0;
+	int samples = 8;
+	std::string exportPath;
+	std::string profilePath;
+	std::string frameStatsPath;
+	std::string shaderCachePath;
+	std::vector<std::string> positional;
+};
+
+RenderOptions parseRenderOptions(int argc, char const *argv[]);
+
+// Owns the GL 3.3 core context a scene renders with. Windowed runs use a GLFW
+// window; headless runs create the context through EGL (surfaceless platform,
+// falling back to a pbuffer) and render into an offscreen framebuffer.
+// Software runs create no context at all and rasterize canvas() on the CPU.
+// Scenes only talk to this class, so the backend is picked per run.
+class RenderContext
+{
+public:
+	~RenderContext();
+
+	bool create(int argc, char const *argv[], const char *title, int width, int height);
+	void destroy();
+
+	bool shouldClose() const;
+	// Presents the frame (swap in a window, MSAA resolve offscreen) and polls events.
+	void swapBuffers();
+	// Declares the frame being rendered identical to the previous one, so the
+	// exporter stores a duplicate reference instead of reading it back and
+	// encoding it. Returns true if the scene may skip drawing it altogether:
+	// offscreen targets keep the last frame, a window needs it drawn again.
+	// Never holds a window frame while the HUD is up.
+	bool holdFrame();
+	// Scene time in seconds. With a fixed fps this only depends on the frame
+	// index, so a scene that derives its state from it can start at any frame.
+	double time() const;
+	// Makes time() count from now. Has no effect on the deterministic clock.
+	void restartClock();
+
+	bool isHeadless() const { return options.headless; }
+	bool isSoftware() const { return options.software; }
+	int width() const { return framebufferWidth; }
+	int height() const { return framebufferHeight; }
+	long frameIndex() const { return frame; }
+	const RenderOptions &renderOptions() const { return options; }
+	// True once a frame went over --alloc-budget. The run's exit code should
+	// say so; also valid after destroy().
+	bool overAllocationBudget() const;
+	GLFWwindow *window() const { return glfwWindow; }
+
+	// 2D drawing for the current backend, created on first use.
+	Canvas &canvas();
+	// Worker threads shared by the scene and the software rasterizer, created on first use.
+	JobSystem &jobs();
+	// Programs loaded from shader files, created on first use and reloaded
+	// when their files change. GL runs only.
+	ShaderLibrary &shaders();
+	// Drawn over every presented frame while visible
+	PerfHud &hud() { return perfHud; }
+	// The values in the FrameUniforms block (FrameUniforms.h) of the current
+	// frame. GL runs upload them once per frame, after the framebuffer size,
+	// the clock and the frame index have moved on.
+	const FrameUniforms &frameUniforms() const { return frameUniformBuffer.values(); }
+
+	// Framebuffer scenes draw into; 0 in a window. Code that binds its own
+	// framebuffer must bind this one again afterwards.
+	GLuint drawFramebuffer() const { return headlessDrawFBO; }
+	// Single-sampled framebuffer holding the last presented frame.
+	GLuint resolvedFramebuffer() const { return options.headless ? headlessResolveFBO : 0; }
+
+private:
+	bool createWindow(const char *title);
+	bool createHeadless();
+	bool createOffscreenTargets();
+	void drawHud(double cpuMs);
+	void updateFrameUniforms();
+
+	RenderOptions options;
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	long frame = 0;
+	bool frameHeld = false;
+	double startTime = 0.0;
+	// When the scene started on the current frame, for its CPU time
+	double frameStartTime = 0.0;
+	bool hudKeyDown = false;
+	PerfHud perfHud;
+	FrameStats frameStats;
+
+	GLFWwindow *glfwWindow = nullptr;
+	FrameExporter exporter;
+	std::unique_ptr<JobSystem> jobSystem;
+	std::unique_ptr<Canvas> sceneCanvas;
+	std::unique_ptr<ShaderLibrary> shaderLibrary;
+	FrameUniformBuffer frameUniformBuffer;
+
+	void *eglDisplay = nullptr;
+	void *eglContext = nullptr;
+	void *eglSurface = nullptr;
+	GLuint headlessDrawFBO = 0, headlessResolveFBO = 0;
+	GLuint colorRenderbuffer = 0, depthRenderbuffer = 0, resolveRenderbuffer = 0;
+};
+
+#endif
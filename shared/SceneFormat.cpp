@@ -0,0 +1,388 @@
+#include "SceneFormat.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+	struct SceneBuilder
+	{
+		std::vector<ScenePoint> points;
+		std::vector<ScenePolyline> polylines;
+		std::vector<uint32_t> indices;
+		std::vector<SceneLabel> labels;
+		std::vector<SceneTrack> tracks;
+		std::string strings;
+		std::map<std::string, uint32_t> pointNames;
+		std::map<std::string, uint32_t> polylineNames;
+	};
+
+	bool reportError(const std::string &path, int lineNumber, const std::string &message)
+	{
+		std::cout << "ERROR::SCENE: " << path << ":" << lineNumber << ": " << message << std::endl;
+		return false;
+	}
+
+	bool readQuoted(std::istringstream &stream, std::string &out)
+	{
+		stream >> std::ws;
+		if (stream.get() != '"')
+			return false;
+		return static_cast<bool>(std::getline(stream, out, '"'));
+	}
+
+	bool parseLine(SceneBuilder &builder, const std::string &path, int lineNumber, const std::string &line)
+	{
+		std::istringstream stream(line);
+		std::string keyword;
+		if (!(stream >> keyword) || keyword[0] == '#')
+			return true;
+
+		if (keyword == "point")
+		{
+			std::string name;
+			ScenePoint point;
+			if (!(stream >> name >> point.x >> point.y))
+				return reportError(path, lineNumber, "expected: point <name> <x> <y>");
+			if (builder.pointNames.count(name))
+				return reportError(path, lineNumber, "duplicate point '" + name + "'");
+			builder.pointNames[name] = static_cast<uint32_t>(builder.points.size());
+			builder.points.push_back(point);
+		}
+		else if (keyword == "polyline")
+		{
+			std::string name, token;
+			if (!(stream >> name))
+				return reportError(path, lineNumber, "expected: polyline <name> <point>... [closed]");
+			ScenePolyline polyline {static_cast<uint32_t>(builder.indices.size()), 0, 0};
+			while (stream >> token)
+			{
+				if (token == "closed") { polyline.closed = 1; continue; }
+				auto point = builder.pointNames.find(token);
+				if (point == builder.pointNames.end())
+					return reportError(path, lineNumber, "unknown point '" + token + "'");
+				builder.indices.push_back(point->second);
+				polyline.indexCount++;
+			}
+			if (polyline.indexCount < 2)
+				return reportError(path, lineNumber, "a polyline needs at least two points");
+			if (builder.polylineNames.count(name))
+				return reportError(path, lineNumber, "duplicate polyline '" + name + "'");
+			builder.polylineNames[name] = static_cast<uint32_t>(builder.polylines.size());
+			builder.polylines.push_back(polyline);
+		}
+		else if (keyword == "label")
+		{
+			std::string pointName, text, option;
+			SceneLabel label {};
+			label.color[0] = 1.0f; label.color[1] = 1.0f; label.color[2] = 1.0f;
+			label.scale = 1.0f;
+			if (!(stream >> pointName) || !readQuoted(stream, text) || !(stream >> label.offsetX >> label.offsetY))
+				return reportError(path, lineNumber, "expected: label <point> \"<text>\" <offsetX> <offsetY>");
+			auto point = builder.pointNames.find(pointName);
+			if (point == builder.pointNames.end())
+				return reportError(path, lineNumber, "unknown point '" + pointName + "'");
+			while (stream >> option)
+			{
+				if (option == "color" && (stream >> label.color[0] >> label.color[1] >> label.color[2]))
+					continue;
+				if (option == "scale" && (stream >> label.scale))
+					continue;
+				return reportError(path, lineNumber, "bad label option '" + option + "'");
+			}
+			label.point = point->second;
+			label.textOffset = static_cast<uint32_t>(builder.strings.size());
+			label.textLength = static_cast<uint32_t>(text.size());
+			builder.strings += text;
+			builder.labels.push_back(label);
+		}
+		else if (keyword == "track")
+		{
+			std::string polylineName, option;
+			SceneTrack track {};
+			if (!(stream >> polylineName >> track.startTime >> track.segmentDuration >> track.holdDuration))
+				return reportError(path, lineNumber, "expected: track <polyline> <start> <segment> <hold> [fill]");
+			auto polyline = builder.polylineNames.find(polylineName);
+			if (polyline == builder.polylineNames.end())
+				return reportError(path, lineNumber, "unknown polyline '" + polylineName + "'");
+			if (track.segmentDuration <= 0.0f)
+				return reportError(path, lineNumber, "segment duration must be positive");
+			if (stream >> option)
+			{
+				if (option != "fill")
+					return reportError(path, lineNumber, "bad track option '" + option + "'");
+				track.fill = 1;
+			}
+			track.polyline = polyline->second;
+			builder.tracks.push_back(track);
+		}
+		else
+		{
+			return reportError(path, lineNumber, "unknown statement '" + keyword + "'");
+		}
+		return true;
+	}
+
+	template <typename T>
+	SceneTable appendTable(std::string &blob, const T *items, size_t count)
+	{
+		// Keep every table 4-byte aligned so it can be read in place.
+		blob.resize((blob.size() + 3) & ~size_t(3), '\0');
+		SceneTable table {static_cast<uint32_t>(blob.size()), static_cast<uint32_t>(count)};
+		blob.append(reinterpret_cast<const char*>(items), count * sizeof(T));
+		return table;
+	}
+
+	bool tableFits(const SceneTable &table, size_t elementSize, size_t fileSize)
+	{
+		return table.offset % 4 == 0 && table.offset <= fileSize &&
+		       static_cast<uint64_t>(table.count) * elementSize <= fileSize - table.offset;
+	}
+
+	template <typename T>
+	const T *tableAt(const void *base, const SceneTable &table)
+	{
+		return reinterpret_cast<const T*>(static_cast<const char*>(base) + table.offset);
+	}
+
+	// Every index one table holds into another and every track timing, checked
+	// once so the accessors and evaluateTrack() can use them unchecked. Needs
+	// the tables to fit.
+	bool referencesValid(const SceneHeader *h)
+	{
+		const ScenePolyline *polylines = tableAt<ScenePolyline>(h, h->polylines);
+		for (uint32_t i = 0; i < h->polylines.count; i++)
+		{
+			// Fewer than two points would wrap the edge count of an open polyline
+			if (polylines[i].indexCount < 2 ||
+			    static_cast<uint64_t>(polylines[i].firstIndex) + polylines[i].indexCount > h->indices.count)
+				return false;
+		}
+
+		const uint32_t *indices = tableAt<uint32_t>(h, h->indices);
+		for (uint32_t i = 0; i < h->indices.count; i++)
+		{
+			if (indices[i] >= h->points.count)
+				return false;
+		}
+
+		const SceneLabel *labels = tableAt<SceneLabel>(h, h->labels);
+		for (uint32_t i = 0; i < h->labels.count; i++)
+		{
+			if (labels[i].point >= h->points.count ||
+			    static_cast<uint64_t>(labels[i].textOffset) + labels[i].textLength > h->strings.count)
+				return false;
+		}
+
+		const SceneTrack *tracks = tableAt<SceneTrack>(h, h->tracks);
+		for (uint32_t i = 0; i < h->tracks.count; i++)
+		{
+			// evaluateTrack() divides by the segment duration
+			if (tracks[i].polyline >= h->polylines.count || !(tracks[i].segmentDuration > 0.0f) ||
+			    !std::isfinite(tracks[i].segmentDuration) || !std::isfinite(tracks[i].holdDuration) ||
+			    !std::isfinite(tracks[i].startTime))
+				return false;
+		}
+		return true;
+	}
+}
+
+bool compileScene(const std::string &textPath, const std::string &binaryPath)
+{
+	std::ifstream input(textPath);
+	if (!input)
+	{
+		std::cout << "ERROR::SCENE: Failed to open " << textPath << std::endl;
+		return false;
+	}
+
+	SceneBuilder builder;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(input, line))
+	{
+		if (!parseLine(builder, textPath, ++lineNumber, line))
+			return false;
+	}
+
+	SceneHeader header {};
+	std::string blob(sizeof(SceneHeader), '\0');
+	header.magic = SCENE_MAGIC;
+	header.version = SCENE_VERSION;
+	header.points = appendTable(blob, builder.points.data(), builder.points.size());
+	header.polylines = appendTable(blob, builder.polylines.data(), builder.polylines.size());
+	header.indices = appendTable(blob, builder.indices.data(), builder.indices.size());
+	header.labels = appendTable(blob, builder.labels.data(), builder.labels.size());
+	header.tracks = appendTable(blob, builder.tracks.data(), builder.tracks.size());
+	header.strings = appendTable(blob, builder.strings.data(), builder.strings.size());
+	header.fileSize = static_cast<uint32_t>(blob.size());
+	std::memcpy(&blob[0], &header, sizeof(header));
+
+	// Per process, frame range workers may all compile the same scene at once
+	std::string temporaryPath = binaryPath + ".tmp" + std::to_string(getpid());
+	{
+		std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!output.write(blob.data(), blob.size()))
+		{
+			std::cout << "ERROR::SCENE: Failed to write " << temporaryPath << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(temporaryPath.c_str(), binaryPath.c_str()) != 0)
+	{
+		std::cout << "ERROR::SCENE: Failed to move " << temporaryPath << " to " << binaryPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+SceneFile::~SceneFile()
+{
+	close();
+}
+
+bool SceneFile::open(const std::string &binaryPath)
+{
+	// The current mapping stays usable until the new file has been validated,
+	// so a failed reload keeps the previous scene on screen.
+	int fd = ::open(binaryPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		std::cout << "ERROR::SCENE: Failed to open " << binaryPath << std::endl;
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SceneHeader))
+	{
+		std::cout << "ERROR::SCENE: " << binaryPath << " is too small to be a scene" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	size_t fileSize = static_cast<size_t>(info.st_size);
+	void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		std::cout << "ERROR::SCENE: Failed to map " << binaryPath << std::endl;
+		return false;
+	}
+
+	// The tables are used in place, so every extent and every reference between
+	// them is checked here; a stale or damaged file is rejected as a whole.
+	const SceneHeader *h = static_cast<const SceneHeader*>(mapping);
+	bool valid = h->magic == SCENE_MAGIC && h->version == SCENE_VERSION && h->fileSize == fileSize &&
+	             tableFits(h->points, sizeof(ScenePoint), fileSize) &&
+	             tableFits(h->polylines, sizeof(ScenePolyline), fileSize) &&
+	             tableFits(h->indices, sizeof(uint32_t), fileSize) &&
+	             tableFits(h->labels, sizeof(SceneLabel), fileSize) &&
+	             tableFits(h->tracks, sizeof(SceneTrack), fileSize) &&
+	             tableFits(h->strings, 1, fileSize) &&
+	             referencesValid(h);
+	if (!valid)
+	{
+		std::cout << "ERROR::SCENE: " << binaryPath << " is not a valid compiled scene" << std::endl;
+		munmap(mapping, fileSize);
+		return false;
+	}
+
+	close();
+	data = mapping;
+	size = fileSize;
+	return true;
+}
+
+void SceneFile::close()
+{
+	if (data)
+		munmap(data, size);
+	data = nullptr;
+	size = 0;
+}
+
+std::string SceneFile::labelText(const SceneLabel &label) const
+{
+	const char *strings = table<char>(header()->strings);
+	return std::string(strings + label.textOffset, label.textLength);
+}
+
+bool loadScene(const std::string &path, SceneFile &scene)
+{
+	const std::string textExtension = ".scene";
+	bool isText = path.size() > textExtension.size() &&
+	              path.compare(path.size() - textExtension.size(), textExtension.size(), textExtension) == 0;
+	if (!isText)
+		return scene.open(path);
+
+	// A compiled file newer than its source is reused; one that fails to open
+	// (written by an older build, say) is compiled again.
+	std::string binaryPath = path + "b";
+	std::error_code binaryError, textError;
+	auto binaryTime = std::filesystem::last_write_time(binaryPath, binaryError);
+	auto textTime = std::filesystem::last_write_time(path, textError);
+	bool fresh = !binaryError && !textError && binaryTime > textTime;
+	if (fresh && scene.open(binaryPath))
+		return true;
+	return compileScene(path, binaryPath) && scene.open(binaryPath);
+}
+
+void polylineFill(const SceneFile &scene, uint32_t polyline, std::vector<glm::vec3> &triangles)
+{
+	const ScenePolyline &p = scene.polylines()[polyline];
+	const uint32_t *indices = scene.indices() + p.firstIndex;
+	for (uint32_t i = 1; i + 1 < p.indexCount; i++)
+	{
+		triangles.push_back(scene.point(indices[0]));
+		triangles.push_back(scene.point(indices[i]));
+		triangles.push_back(scene.point(indices[i + 1]));
+	}
+}
+
+bool evaluateTrack(const SceneFile &scene, const SceneTrack &track, float time,
+                   std::vector<glm::vec3> &linePoints)
+{
+	const ScenePolyline &polyline = scene.polylines()[track.polyline];
+	const uint32_t *indices = scene.indices() + polyline.firstIndex;
+	uint32_t edgeCount = polyline.closed ? polyline.indexCount : polyline.indexCount - 1;
+
+	float local = time - track.startTime;
+	if (local <= 0.0f)
+		return false;
+
+	for (uint32_t edge = 0; edge < edgeCount; edge++)
+	{
+		glm::vec3 start = scene.point(indices[edge]);
+		glm::vec3 end = scene.point(indices[(edge + 1) % polyline.indexCount]);
+		float localT = (local - edge * track.segmentDuration) / track.segmentDuration;
+		if (localT <= 0.0f)
+			break;
+
+		linePoints.push_back(start);
+		linePoints.push_back(localT >= 1.0f ? end : start + localT * (end - start));
+	}
+	return local >= edgeCount * track.segmentDuration + track.holdDuration;
+}
+
+float sceneEndTime(const SceneFile &scene)
+{
+	float end = 0.0f;
+	for (uint32_t i = 0; i < scene.trackCount(); i++)
+	{
+		const SceneTrack &track = scene.tracks()[i];
+		const ScenePolyline &polyline = scene.polylines()[track.polyline];
+		uint32_t edgeCount = polyline.closed ? polyline.indexCount : polyline.indexCount - 1;
+		end = std::max(end, track.startTime + edgeCount * track.segmentDuration + track.holdDuration);
+	}
+	return end;
+}
@@ -0,0 +1,144 @@
+#ifndef SCENE_FORMAT_H
+#define SCENE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm/glm.hpp>
+
+/*
+  Scene description, text form (*.scene), one statement per line, '#' starts a comment:
+
+      point    <name> <x> <y>
+      polyline <name> <point> <point> ... [closed]
+      label    <point> "<text>" <offsetX> <offsetY> [color <r> <g> <b>] [scale <s>]
+      track    <polyline> <start> <segmentDuration> <holdDuration> [fill]
+
+  Coordinates are NDC. A track draws the edges of its polyline one after
+  another, each edge taking segmentDuration seconds, then holds for
+  holdDuration seconds before the polyline is considered complete (and
+  filled when `fill` is given).
+
+  The compiled form (*.sceneb) is the same data laid out as flat tables
+  behind a SceneHeader, so it can be mmap'ed and used without parsing.
+*/
+
+const uint32_t SCENE_MAGIC = 0x43534e41; // "ANSC"
+const uint32_t SCENE_VERSION = 1;
+
+struct SceneTable
+{
+	uint32_t offset;  // byte offset from the start of the file
+	uint32_t count;   // number of elements
+};
+
+struct SceneHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t fileSize;
+	uint32_t reserved;
+	SceneTable points;     // ScenePoint
+	SceneTable polylines;  // ScenePolyline
+	SceneTable indices;    // uint32_t, point indices referenced by polylines
+	SceneTable labels;     // SceneLabel
+	SceneTable tracks;     // SceneTrack
+	SceneTable strings;    // char, label text (not null terminated)
+};
+
+struct ScenePoint
+{
+	float x;
+	float y;
+};
+
+struct ScenePolyline
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t closed;
+};
+
+struct SceneLabel
+{
+	uint32_t point;
+	uint32_t textOffset;
+	uint32_t textLength;
+	float offsetX;
+	float offsetY;
+	float color[3];
+	float scale;
+};
+
+struct SceneTrack
+{
+	uint32_t polyline;
+	uint32_t fill;
+	float startTime;
+	float segmentDuration;
+	float holdDuration;
+};
+
+// Parses the text form and writes the binary form. The output is written to a
+// temporary file and renamed into place so readers never see a partial file.
+bool compileScene(const std::string &textPath, const std::string &binaryPath);
+
+// Read-only view of a compiled scene mapped into memory.
+class SceneFile
+{
+public:
+	SceneFile() = default;
+	~SceneFile();
+
+	SceneFile(const SceneFile&) = delete;
+	SceneFile& operator=(const SceneFile&) = delete;
+
+	bool open(const std::string &binaryPath);
+	void close();
+	bool isOpen() const { return data != nullptr; }
+
+	const ScenePoint *points() const { return table<ScenePoint>(header()->points); }
+	uint32_t pointCount() const { return header()->points.count; }
+	const ScenePolyline *polylines() const { return table<ScenePolyline>(header()->polylines); }
+	uint32_t polylineCount() const { return header()->polylines.count; }
+	const uint32_t *indices() const { return table<uint32_t>(header()->indices); }
+	const SceneLabel *labels() const { return table<SceneLabel>(header()->labels); }
+	uint32_t labelCount() const { return header()->labels.count; }
+	const SceneTrack *tracks() const { return table<SceneTrack>(header()->tracks); }
+	uint32_t trackCount() const { return header()->tracks.count; }
+
+	glm::vec3 point(uint32_t index) const { return glm::vec3(points()[index].x, points()[index].y, 0.0f); }
+	std::string labelText(const SceneLabel &label) const;
+
+private:
+	const SceneHeader *header() const { return static_cast<const SceneHeader*>(data); }
+	template <typename T>
+	const T *table(const SceneTable &t) const
+	{
+		return reinterpret_cast<const T*>(static_cast<const char*>(data) + t.offset);
+	}
+
+	void *data = nullptr;
+	size_t size = 0;
+};
+
+// Opens a scene from either form. A *.scene text file is compiled next to
+// itself (as *.sceneb) first, unless the compiled file is already newer.
+bool loadScene(const std::string &path, SceneFile &scene);
+
+// Appends the edges of `track` that are visible at `time` to linePoints as
+// GL_LINES pairs, the edge in progress ending at its interpolated position.
+// Returns true once every edge is drawn and the hold time has passed.
+bool evaluateTrack(const SceneFile &scene, const SceneTrack &track, float time,
+                   std::vector<glm::vec3> &linePoints);
+
+// Time at which the last track of the scene has finished
+float sceneEndTime(const SceneFile &scene);
+
+// Appends a triangle fan over the polyline as a GL_TRIANGLES list. The
+// outline is expected to be convex.
+void polylineFill(const SceneFile &scene, uint32_t polyline, std::vector<glm::vec3> &triangles);
+
+#endif
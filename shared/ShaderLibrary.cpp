@@ -0,0 +1,180 @@
+#include "ShaderLibrary.h"
+#include "GlResourceTracker.h"
+#include "ProgramCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	std::string normalizedPath(const std::string &path)
+	{
+		// The form FileWatcher reports changes in
+		return std::filesystem::absolute(path).lexically_normal().string();
+	}
+
+	// Adds "#line" after the #version line, so the compiler counts lines the
+	// way the file does. `firstLine` is the file line the stage starts on.
+	std::string withLineDirective(const std::string &stage, unsigned int firstLine)
+	{
+		size_t version = stage.find("#version");
+		if (version == std::string::npos)
+			return "#line " + std::to_string(firstLine) + "\n" + stage;
+		size_t lineEnd = stage.find('\n', version);
+		if (lineEnd == std::string::npos)
+			return stage;
+		unsigned int versionLine = firstLine;
+		for (size_t i = 0; i < lineEnd; i++)
+			if (stage[i] == '\n')
+				versionLine++;
+		return stage.substr(0, lineEnd + 1) + "#line " + std::to_string(versionLine + 1) + "\n" + stage.substr(lineEnd + 1);
+	}
+}
+
+bool parseShaderFile(const std::string &path, ShaderFileSource &source)
+{
+	std::ifstream stream(path);
+	if (!stream)
+	{
+		std::cout << "ERROR::SHADER: Failed to open " << path << std::endl;
+		return false;
+	}
+
+	enum class ShaderType { NONE, VERTEX, FRAGMENT };
+	ShaderType type = ShaderType::NONE;
+	source = ShaderFileSource();
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+		if (line.find("#shader") != std::string::npos)
+		{
+			if (line.find("vertex") != std::string::npos)
+			{
+				type = ShaderType::VERTEX;
+				source.vertexLine = lineNumber + 1;
+			}
+			else if (line.find("fragment") != std::string::npos)
+			{
+				type = ShaderType::FRAGMENT;
+				source.fragmentLine = lineNumber + 1;
+			}
+			else
+			{
+				std::cout << "ERROR::SHADER: " << path << ":" << lineNumber << ": unknown stage, expected vertex or fragment" << std::endl;
+				type = ShaderType::NONE;
+			}
+		}
+		else if (type == ShaderType::VERTEX)
+			source.vertex += line + "\n";
+		else if (type == ShaderType::FRAGMENT)
+			source.fragment += line + "\n";
+	}
+
+	if (source.vertexLine == 0 || source.fragmentLine == 0)
+	{
+		std::cout << "ERROR::SHADER: " << path << " needs both a #shader vertex and a #shader fragment section" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+	release();
+}
+
+const ShaderProgram &ShaderLibrary::load(const std::string &path, const std::string &defines)
+{
+	std::string normalized = normalizedPath(path);
+	std::unique_ptr<Entry> &entry = entries[std::make_pair(normalized, defines)];
+	if (entry)
+		return entry->program;
+
+	entry = std::make_unique<Entry>();
+	entry->program.path = normalized;
+	entry->program.defines = defines;
+	if (!watcher)
+		watcher = std::make_unique<FileWatcher>();
+	watcher->watch(normalized);
+	build(*entry);
+	return entry->program;
+}
+
+bool ShaderLibrary::build(Entry &entry)
+{
+	ShaderProgram &program = entry.program;
+	ShaderFileSource source;
+	if (!parseShaderFile(program.path, source))
+		return false;
+
+	std::string vertex = withLineDirective(source.vertex, source.vertexLine);
+	std::string fragment = withLineDirective(source.fragment, source.fragmentLine);
+	std::string key = vertex + '\0' + fragment + '\0' + program.defines;
+	if (key == entry.linkedKey)
+		return false;
+
+	Linked &shared = linked[key];
+	if (!shared.id)
+	{
+		GL_RESOURCE_SITE("ShaderLibrary");
+		shared.id = loadProgram(program.path.c_str(), vertex.c_str(), fragment.c_str(), program.defines);
+		if (!shared.id)
+		{
+			// Keep whatever linked last
+			linked.erase(key);
+			return false;
+		}
+	}
+	shared.users++;
+
+	if (!entry.linkedKey.empty())
+		releaseLinked(entry.linkedKey);
+	entry.linkedKey = key;
+	program.id = shared.id;
+	program.version++;
+	return true;
+}
+
+void ShaderLibrary::releaseLinked(const std::string &key)
+{
+	auto it = linked.find(key);
+	if (it == linked.end())
+		return;
+	if (--it->second.users == 0)
+	{
+		glDeleteProgram(it->second.id);
+		linked.erase(it);
+	}
+}
+
+bool ShaderLibrary::reload()
+{
+	if (!watcher)
+		return false;
+	bool changed = false;
+	for (const std::string &path : watcher->poll())
+	{
+		for (auto &entry : entries)
+		{
+			if (entry.first.first != path)
+				continue;
+			if (build(*entry.second))
+			{
+				std::cout << "Reloaded " << path << std::endl;
+				changed = true;
+			}
+		}
+	}
+	return changed;
+}
+
+void ShaderLibrary::release()
+{
+	for (auto &shared : linked)
+		glDeleteProgram(shared.second.id);
+	linked.clear();
+	entries.clear();
+	watcher.reset();
+}
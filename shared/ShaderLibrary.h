@@ -0,0 +1,99 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <glad/glad.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "FileWatcher.h"
+
+// Both stages of a program, read from one file:
+//
+//   #shader vertex
+//   #version 330 core
+//   ...
+//   #shader fragment
+//   #version 330 core
+//   ...
+//
+// `vertexLine` and `fragmentLine` are the file lines the stages start on.
+struct ShaderFileSource
+{
+	std::string vertex;
+	std::string fragment;
+	unsigned int vertexLine = 0;
+	unsigned int fragmentLine = 0;
+};
+
+// Returns false if the file cannot be read or lacks one of the stages.
+bool parseShaderFile(const std::string &path, ShaderFileSource &source);
+
+// A linked program owned by the library. `id` changes when the file is
+// edited and compiles again, and `version` counts those changes, so code
+// that caches uniform locations looks them up again when it moves.
+struct ShaderProgram
+{
+	GLuint id = 0;
+	unsigned int version = 0;
+	std::string path;
+	std::string defines;
+};
+
+// Loads shader files once and keeps them up to date. Every file is linked
+// through the program cache (ProgramCache.h) with #line directives, so
+// compile and link errors point at "file:line". Identical sources share one
+// GL program, even when they come from different files or with different
+// paths to the same file.
+//
+// reload() recompiles the files that changed on disk (inotify, FileWatcher.h)
+// and swaps the new program in. A file that no longer compiles keeps its last
+// working program, after printing the errors. RenderContext owns one library
+// (RenderContext::shaders()), reloads it every frame and releases it before
+// the context goes away.
+class ShaderLibrary
+{
+public:
+	ShaderLibrary() = default;
+	~ShaderLibrary();
+
+	ShaderLibrary(const ShaderLibrary&) = delete;
+	ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+	// The program of `path`, built on the first request. The reference stays
+	// valid until release(); `id` is 0 if the file never compiled.
+	const ShaderProgram &load(const std::string &path, const std::string &defines = std::string());
+
+	// Rebuilds the programs whose file changed. Returns true if any of them
+	// got a new id. Never blocks when nothing changed.
+	bool reload();
+
+	// Deletes every program; needs the GL context to still be current.
+	void release();
+
+private:
+	struct Entry
+	{
+		ShaderProgram program;
+		// Key of the shared program in `linked`, empty before the first build
+		std::string linkedKey;
+	};
+	struct Linked
+	{
+		GLuint id = 0;
+		unsigned int users = 0;
+	};
+
+	// Builds the entry from its file and points it at the (possibly shared) result
+	bool build(Entry &entry);
+	void releaseLinked(const std::string &key);
+
+	std::map<std::pair<std::string, std::string>, std::unique_ptr<Entry>> entries;
+	// Keyed by both stages and the defines, exactly as compiled
+	std::unordered_map<std::string, Linked> linked;
+	std::unique_ptr<FileWatcher> watcher;
+};
+
+#endif
@@ -0,0 +1,458 @@
+#include "SoftCanvas.h"
+#include "AllocationTracker.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+	const int TILE_SIZE = 64;
+
+	// Source-over with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA applied to all four
+	// channels, the same blend state the GL canvas uses.
+	inline void blendPixel(float *dst, const glm::vec4 &color, float coverage)
+	{
+		float a = color.a * coverage;
+#ifdef __SSE2__
+		__m128 alpha = _mm_set1_ps(a);
+		__m128 src = _mm_mul_ps(_mm_loadu_ps(&color.r), alpha);
+		__m128 d = _mm_loadu_ps(dst);
+		_mm_storeu_ps(dst, _mm_add_ps(src, _mm_mul_ps(d, _mm_sub_ps(_mm_set1_ps(1.0f), alpha))));
+#else
+		float inverse = 1.0f - a;
+		dst[0] = color.r * a + dst[0] * inverse;
+		dst[1] = color.g * a + dst[1] * inverse;
+		dst[2] = color.b * a + dst[2] * inverse;
+		dst[3] = color.a * a + dst[3] * inverse;
+#endif
+	}
+
+	struct TileRect
+	{
+		int x0, y0, x1, y1;   // [x0, x1) x [y0, y1) in pixels
+	};
+
+	// Pixel rows [firstY, lastY] and columns [firstX, lastX] of a bounding box
+	// whose pixel centers can lie inside it, clipped to the tile.
+	inline bool clipToTile(const TileRect &tile, float minX, float minY, float maxX, float maxY,
+	                       int &firstX, int &firstY, int &lastX, int &lastY)
+	{
+		firstX = std::max(tile.x0, static_cast<int>(std::floor(minX)));
+		firstY = std::max(tile.y0, static_cast<int>(std::floor(minY)));
+		lastX = std::min(tile.x1 - 1, static_cast<int>(std::ceil(maxX)));
+		lastY = std::min(tile.y1 - 1, static_cast<int>(std::ceil(maxY)));
+		return firstX <= lastX && firstY <= lastY;
+	}
+
+	void fillTriangle(const TileRect &tile, float *buffer, glm::vec2 v0, glm::vec2 v1, glm::vec2 v2, const glm::vec4 &color)
+	{
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (area == 0.0f)
+			return;
+		// GL draws both windings, bring every triangle to counter-clockwise
+		if (area < 0.0f)
+			std::swap(v1, v2);
+
+		int firstX, firstY, lastX, lastY;
+		if (!clipToTile(tile, std::min({v0.x, v1.x, v2.x}), std::min({v0.y, v1.y, v2.y}),
+		                std::max({v0.x, v1.x, v2.x}), std::max({v0.y, v1.y, v2.y}),
+		                firstX, firstY, lastX, lastY))
+			return;
+
+		// E(p) = A * p.x + B * p.y + C is positive left of each edge. Pixels exactly
+		// on an edge belong to it only for top and left edges, so shared edges
+		// are not drawn twice.
+		const glm::vec2 edgeStart[3] = { v0, v1, v2 };
+		const glm::vec2 edgeEnd[3] = { v1, v2, v0 };
+		float A[3], B[3], C[3];
+		bool inclusive[3];
+		for (int i = 0; i < 3; i++)
+		{
+			glm::vec2 d = edgeEnd[i] - edgeStart[i];
+			A[i] = -d.y;
+			B[i] = d.x;
+			C[i] = -(A[i] * edgeStart[i].x + B[i] * edgeStart[i].y);
+			inclusive[i] = d.y < 0.0f || (d.y == 0.0f && d.x < 0.0f);
+		}
+
+		const int stride = TILE_SIZE * 4;
+		for (int y = firstY; y <= lastY; y++)
+		{
+			float py = y + 0.5f;
+			float *row = buffer + (y - tile.y0) * stride;
+#ifdef __SSE2__
+			__m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			__m128 e[3], step[3];
+			for (int i = 0; i < 3; i++)
+			{
+				__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(firstX)), laneOffsets);
+				e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[i]), px), _mm_set1_ps(B[i] * py + C[i]));
+				step[i] = _mm_set1_ps(A[i] * 4.0f);
+			}
+			__m128 zero = _mm_setzero_ps();
+			for (int x = firstX; x <= lastX; x += 4)
+			{
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int i = 0; i < 3; i++)
+					inside = _mm_and_ps(inside, inclusive[i] ? _mm_cmpge_ps(e[i], zero) : _mm_cmpgt_ps(e[i], zero));
+				int mask = _mm_movemask_ps(inside);
+				if (lastX - x < 3)
+					mask &= (1 << (lastX - x + 1)) - 1;
+				while (mask)
+				{
+					int lane = __builtin_ctz(mask);
+					mask &= mask - 1;
+					blendPixel(row + (x + lane - tile.x0) * 4, color, 1.0f);
+				}
+				for (int i = 0; i < 3; i++)
+					e[i] = _mm_add_ps(e[i], step[i]);
+			}
+#else
+			for (int x = firstX; x <= lastX; x++)
+			{
+				float px = x + 0.5f;
+				bool inside = true;
+				for (int i = 0; i < 3 && inside; i++)
+				{
+					float e = A[i] * px + B[i] * py + C[i];
+					inside = inclusive[i] ? e >= 0.0f : e > 0.0f;
+				}
+				if (inside)
+					blendPixel(row + (x - tile.x0) * 4, color, 1.0f);
+			}
+#endif
+		}
+	}
+
+	// Coverage falls off linearly over one pixel around a capsule of the line's
+	// width, which is what an anti-aliased GL line looks like at small widths.
+	void drawLine(const TileRect &tile, float *buffer, glm::vec2 a, glm::vec2 b, float width, const glm::vec4 &color)
+	{
+		float reach = width * 0.5f + 0.5f;
+		int firstX, firstY, lastX, lastY;
+		if (!clipToTile(tile, std::min(a.x, b.x) - reach, std::min(a.y, b.y) - reach,
+		                std::max(a.x, b.x) + reach, std::max(a.y, b.y) + reach,
+		                firstX, firstY, lastX, lastY))
+			return;
+
+		glm::vec2 d = b - a;
+		float lengthSquared = glm::dot(d, d);
+		float inverseLengthSquared = lengthSquared > 0.0f ? 1.0f / lengthSquared : 0.0f;
+
+		const int stride = TILE_SIZE * 4;
+		for (int y = firstY; y <= lastY; y++)
+		{
+			float dy = y + 0.5f - a.y;
+			float *row = buffer + (y - tile.y0) * stride;
+#ifdef __SSE2__
+			__m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+			__m128 vdy = _mm_set1_ps(dy);
+			__m128 dirX = _mm_set1_ps(d.x), dirY = _mm_set1_ps(d.y);
+			__m128 dx = _mm_add_ps(_mm_set1_ps(firstX - a.x), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+			for (int x = firstX; x <= lastX; x += 4)
+			{
+				__m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, dirX), _mm_mul_ps(vdy, dirY)), _mm_set1_ps(inverseLengthSquared));
+				t = _mm_min_ps(_mm_max_ps(t, zero), one);
+				__m128 ex = _mm_sub_ps(dx, _mm_mul_ps(t, dirX));
+				__m128 ey = _mm_sub_ps(vdy, _mm_mul_ps(t, dirY));
+				__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+				__m128 coverage = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(reach), distance), zero), one);
+
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, coverage);
+				int count = std::min(4, lastX - x + 1);
+				for (int lane = 0; lane < count; lane++)
+					if (lanes[lane] > 0.0f)
+						blendPixel(row + (x + lane - tile.x0) * 4, color, lanes[lane]);
+				dx = _mm_add_ps(dx, _mm_set1_ps(4.0f));
+			}
+#else
+			for (int x = firstX; x <= lastX; x++)
+			{
+				float dx = x + 0.5f - a.x;
+				float t = std::clamp((dx * d.x + dy * d.y) * inverseLengthSquared, 0.0f, 1.0f);
+				float ex = dx - t * d.x, ey = dy - t * d.y;
+				float coverage = std::clamp(reach - std::sqrt(ex * ex + ey * ey), 0.0f, 1.0f);
+				if (coverage > 0.0f)
+					blendPixel(row + (x - tile.x0) * 4, color, coverage);
+			}
+#endif
+		}
+	}
+
+	// Covers the pixel centers inside a size x size square, like a GL point sprite
+	void drawPoint(const TileRect &tile, float *buffer, glm::vec2 center, float size, const glm::vec4 &color)
+	{
+		float half = size * 0.5f;
+		int firstX = std::max(tile.x0, static_cast<int>(std::ceil(center.x - half - 0.5f)));
+		int firstY = std::max(tile.y0, static_cast<int>(std::ceil(center.y - half - 0.5f)));
+		int endX = std::min(tile.x1, static_cast<int>(std::ceil(center.x + half - 0.5f)));
+		int endY = std::min(tile.y1, static_cast<int>(std::ceil(center.y + half - 0.5f)));
+		for (int y = firstY; y < endY; y++)
+		{
+			float *row = buffer + (y - tile.y0) * TILE_SIZE * 4;
+			for (int x = firstX; x < endX; x++)
+				blendPixel(row + (x - tile.x0) * 4, color, 1.0f);
+		}
+	}
+
+	// Bilinear lookup into the 8-bit atlas, matching the GL_LINEAR atlas texture
+	inline float sampleAtlas(const GlyphAtlas &atlas, float u, float v)
+	{
+		float tx = u * atlas.width() - 0.5f;
+		float ty = v * atlas.height() - 0.5f;
+		int x0 = static_cast<int>(std::floor(tx));
+		int y0 = static_cast<int>(std::floor(ty));
+		float fx = tx - x0, fy = ty - y0;
+		const unsigned char *bitmap = atlas.pixels().data();
+		auto texel = [&](int x, int y) {
+			x = std::clamp(x, 0, atlas.width() - 1);
+			y = std::clamp(y, 0, atlas.height() - 1);
+			return static_cast<float>(bitmap[y * atlas.width() + x]);
+		};
+		float top = texel(x0, y0) + (texel(x0 + 1, y0) - texel(x0, y0)) * fx;
+		float bottom = texel(x0, y0 + 1) + (texel(x0 + 1, y0 + 1) - texel(x0, y0 + 1)) * fx;
+		return (top + (bottom - top) * fy) * (1.0f / 255.0f);
+	}
+
+	void drawGlyph(const TileRect &tile, float *buffer, const GlyphAtlas &atlas, const GlyphQuad &q, const glm::vec4 &color)
+	{
+		int firstX = std::max(tile.x0, static_cast<int>(std::ceil(q.x0 - 0.5f)));
+		int firstY = std::max(tile.y0, static_cast<int>(std::ceil(q.y0 - 0.5f)));
+		int endX = std::min(tile.x1, static_cast<int>(std::ceil(q.x1 - 0.5f)));
+		int endY = std::min(tile.y1, static_cast<int>(std::ceil(q.y1 - 0.5f)));
+		float du = (q.u1 - q.u0) / (q.x1 - q.x0);
+		float dv = (q.v1 - q.v0) / (q.y1 - q.y0);
+		for (int y = firstY; y < endY; y++)
+		{
+			float *row = buffer + (y - tile.y0) * TILE_SIZE * 4;
+			// v0 is the top edge, rows are bottom-up
+			float v = q.v0 + (q.y1 - (y + 0.5f)) * dv;
+			for (int x = firstX; x < endX; x++)
+			{
+				float coverage = sampleAtlas(atlas, q.u0 + (x + 0.5f - q.x0) * du, v);
+				if (coverage > 0.0f)
+					blendPixel(row + (x - tile.x0) * 4, color, coverage);
+			}
+		}
+	}
+
+	inline unsigned char toByte(float value)
+	{
+		return static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+SoftCanvas::SoftCanvas(int width, int height, JobSystem *jobs)
+	: canvasWidth(width), canvasHeight(height), jobs(jobs)
+{
+	tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	tiles.resize(static_cast<size_t>(tilesX) * tilesY);
+	for (int ty = 0; ty < tilesY; ty++)
+	{
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			Tile &tile = tiles[ty * tilesX + tx];
+			tile.x0 = tx * TILE_SIZE;
+			tile.y0 = ty * TILE_SIZE;
+			tile.x1 = std::min(width, tile.x0 + TILE_SIZE);
+			tile.y1 = std::min(height, tile.y0 + TILE_SIZE);
+		}
+	}
+	colorBuffer.assign(static_cast<size_t>(width) * height * 4, 0);
+}
+
+bool SoftCanvas::loadFont(const std::string &fontPath, unsigned int pixelSize)
+{
+	return atlas.load(fontPath, pixelSize);
+}
+
+glm::vec2 SoftCanvas::toPixels(const glm::vec3 &p) const
+{
+	return glm::vec2((p.x + 1.0f) * 0.5f * canvasWidth, (p.y + 1.0f) * 0.5f * canvasHeight);
+}
+
+uint32_t SoftCanvas::addStyle(const glm::vec4 &color, float size)
+{
+	styles.push_back({color, size});
+	return static_cast<uint32_t>(styles.size() - 1);
+}
+
+void SoftCanvas::addPrimitive(PrimitiveType type, uint32_t first, uint32_t style, float minX, float minY, float maxX, float maxY)
+{
+	int tx0 = std::max(0, static_cast<int>(std::floor(minX)) / TILE_SIZE);
+	int ty0 = std::max(0, static_cast<int>(std::floor(minY)) / TILE_SIZE);
+	int tx1 = std::min(tilesX - 1, static_cast<int>(std::ceil(maxX)) / TILE_SIZE);
+	int ty1 = std::min(tilesY - 1, static_cast<int>(std::ceil(maxY)) / TILE_SIZE);
+	if (maxX < 0.0f || maxY < 0.0f || tx0 > tx1 || ty0 > ty1)
+		return;
+
+	uint32_t index = static_cast<uint32_t>(primitives.size());
+	primitives.push_back({type, first, style});
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++)
+			tiles[ty * tilesX + tx].primitives.push_back(index);
+}
+
+void SoftCanvas::clear(const glm::vec4 &color)
+{
+	clearColor = color;
+	vertices.clear();
+	glyphQuads.clear();
+	styles.clear();
+	primitives.clear();
+	for (Tile &tile : tiles)
+		tile.primitives.clear();
+}
+
+void SoftCanvas::drawPoints(const glm::vec3 *points, size_t count, float sizeInPixels, const glm::vec4 &color)
+{
+	uint32_t style = addStyle(color, sizeInPixels);
+	float half = sizeInPixels * 0.5f;
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec2 p = toPixels(points[i]);
+		uint32_t first = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(p);
+		addPrimitive(PrimitiveType::Point, first, style, p.x - half, p.y - half, p.x + half, p.y + half);
+	}
+}
+
+void SoftCanvas::drawLines(const glm::vec3 *points, size_t count, float widthInPixels, const glm::vec4 &color)
+{
+	uint32_t style = addStyle(color, widthInPixels);
+	float reach = widthInPixels * 0.5f + 0.5f;
+	for (size_t i = 0; i + 1 < count; i += 2)
+	{
+		glm::vec2 a = toPixels(points[i]), b = toPixels(points[i + 1]);
+		uint32_t first = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(a);
+		vertices.push_back(b);
+		addPrimitive(PrimitiveType::Line, first, style,
+		             std::min(a.x, b.x) - reach, std::min(a.y, b.y) - reach,
+		             std::max(a.x, b.x) + reach, std::max(a.y, b.y) + reach);
+	}
+}
+
+void SoftCanvas::drawTriangles(const glm::vec3 *points, size_t count, const glm::vec4 &color)
+{
+	uint32_t style = addStyle(color, 0.0f);
+	for (size_t i = 0; i + 2 < count; i += 3)
+	{
+		glm::vec2 a = toPixels(points[i]), b = toPixels(points[i + 1]), c = toPixels(points[i + 2]);
+		uint32_t first = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(a);
+		vertices.push_back(b);
+		vertices.push_back(c);
+		addPrimitive(PrimitiveType::Triangle, first, style,
+		             std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y}),
+		             std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y}));
+	}
+}
+
+void SoftCanvas::drawText(const std::string &text, float x, float y, float scale, const glm::vec3 &color)
+{
+	if (!atlas.isLoaded())
+		return;
+
+	size_t first = glyphQuads.size();
+	atlas.layoutText(text, x, y, scale, glyphQuads);
+	uint32_t style = addStyle(glm::vec4(color, 1.0f), 0.0f);
+	for (size_t i = first; i < glyphQuads.size(); i++)
+	{
+		const GlyphQuad &q = glyphQuads[i];
+		addPrimitive(PrimitiveType::Glyph, static_cast<uint32_t>(i), style, q.x0, q.y0, q.x1, q.y1);
+	}
+}
+
+void SoftCanvas::rasterizeTile(Tile &tile, float *buffer)
+{
+	const int tileWidth = tile.x1 - tile.x0;
+	if (tile.primitives.empty())
+	{
+		// Nothing drawn here, write the clear color straight out
+		unsigned char clearBytes[4] = { toByte(clearColor.r), toByte(clearColor.g), toByte(clearColor.b), toByte(clearColor.a) };
+		for (int y = tile.y0; y < tile.y1; y++)
+		{
+			unsigned char *dst = colorBuffer.data() + (static_cast<size_t>(y) * canvasWidth + tile.x0) * 4;
+			for (int x = 0; x < tileWidth; x++)
+				std::memcpy(dst + x * 4, clearBytes, 4);
+		}
+		return;
+	}
+
+	for (int i = 0; i < TILE_SIZE * TILE_SIZE; i++)
+		std::memcpy(buffer + i * 4, &clearColor.r, sizeof(float) * 4);
+
+	TileRect rect { tile.x0, tile.y0, tile.x1, tile.y1 };
+	for (uint32_t index : tile.primitives)
+	{
+		const Primitive &primitive = primitives[index];
+		const Style &style = styles[primitive.style];
+		const glm::vec2 *v = vertices.data() + primitive.first;
+		switch (primitive.type)
+		{
+		case PrimitiveType::Point:
+			drawPoint(rect, buffer, v[0], style.size, style.color);
+			break;
+		case PrimitiveType::Line:
+			drawLine(rect, buffer, v[0], v[1], style.size, style.color);
+			break;
+		case PrimitiveType::Triangle:
+			fillTriangle(rect, buffer, v[0], v[1], v[2], style.color);
+			break;
+		case PrimitiveType::Glyph:
+			drawGlyph(rect, buffer, atlas, glyphQuads[primitive.first], style.color);
+			break;
+		}
+	}
+
+	for (int y = tile.y0; y < tile.y1; y++)
+	{
+		const float *src = buffer + (y - tile.y0) * TILE_SIZE * 4;
+		unsigned char *dst = colorBuffer.data() + (static_cast<size_t>(y) * canvasWidth + tile.x0) * 4;
+#ifdef __SSE2__
+		__m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+		__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		for (int x = 0; x < tileWidth; x++)
+		{
+			__m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + x * 4), zero), one);
+			__m128i integers = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			integers = _mm_packs_epi32(integers, integers);
+			integers = _mm_packus_epi16(integers, integers);
+			int packed = _mm_cvtsi128_si32(integers);
+			std::memcpy(dst + x * 4, &packed, 4);
+		}
+#else
+		for (int x = 0; x < tileWidth * 4; x++)
+			dst[x] = toByte(src[x]);
+#endif
+	}
+}
+
+void SoftCanvas::flush()
+{
+	PROFILE_SCOPE("SoftCanvas::flush");
+	ALLOC_TAG("SoftCanvas::flush");
+	auto rasterizeRange = [this](size_t begin, size_t end) {
+		PROFILE_SCOPE("SoftCanvas::rasterizeTiles");
+		// One float RGBA tile per thread, reused across frames
+		thread_local std::vector<float> buffer(TILE_SIZE * TILE_SIZE * 4);
+		for (size_t i = begin; i < end; i++)
+			rasterizeTile(tiles[i], buffer.data());
+	};
+
+	if (jobs)
+		jobs->parallelFor(0, tiles.size(), 1, rasterizeRange);
+	else
+		rasterizeRange(0, tiles.size());
+
+	clear(clearColor);
+}
@@ -0,0 +1,87 @@
+#ifndef SOFT_CANVAS_H
+#define SOFT_CANVAS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Canvas.h"
+#include "GlyphAtlas.h"
+
+class JobSystem;
+
+// Canvas rasterized on the CPU, for machines without a GPU. Draw calls are
+// only recorded; flush() bins every primitive into 64x64 pixel tiles and
+// rasterizes the tiles in parallel on the job system, each tile replaying
+// its primitives in call order. Triangles are filled with SSE2 edge
+// functions four pixels at a time, lines get analytic anti-aliasing, points
+// are square sprites and text is blitted from the glyph atlas.
+class SoftCanvas : public Canvas
+{
+public:
+	// Without a job system the tiles are rasterized on the calling thread.
+	SoftCanvas(int width, int height, JobSystem *jobs = nullptr);
+
+	bool loadFont(const std::string &fontPath, unsigned int pixelSize) override;
+
+	void clear(const glm::vec4 &color) override;
+	void drawPoints(const glm::vec3 *points, size_t count, float sizeInPixels, const glm::vec4 &color) override;
+	void drawLines(const glm::vec3 *points, size_t count, float widthInPixels, const glm::vec4 &color) override;
+	void drawTriangles(const glm::vec3 *points, size_t count, const glm::vec4 &color) override;
+	void drawText(const std::string &text, float x, float y, float scale, const glm::vec3 &color) override;
+	unsigned int fontPixelSize() const override { return atlas.isLoaded() ? atlas.pixelSize() : 0; }
+	void flush() override;
+
+	int width() const override { return canvasWidth; }
+	int height() const override { return canvasHeight; }
+
+	// RGBA8, rows bottom-up like glReadPixels. Valid after flush().
+	const std::vector<unsigned char> &pixels() const { return colorBuffer; }
+	// Exchanges the color buffer with `buffer` (width * height * 4 bytes), so
+	// a finished frame can be handed on without a copy. Every flush() writes
+	// all pixels, the contents of the buffer given in do not matter.
+	void swapPixels(std::vector<unsigned char> &buffer) { colorBuffer.swap(buffer); }
+
+private:
+	enum class PrimitiveType : uint8_t { Point, Line, Triangle, Glyph };
+
+	// Vertices are in pixel space. Points use one vertex, lines two, triangles
+	// three; a glyph references one entry of glyphQuads instead.
+	struct Primitive
+	{
+		PrimitiveType type;
+		uint32_t first;
+		uint32_t style;
+	};
+
+	struct Style
+	{
+		glm::vec4 color;
+		float size;
+	};
+
+	struct Tile
+	{
+		int x0, y0, x1, y1;
+		std::vector<uint32_t> primitives;
+	};
+
+	glm::vec2 toPixels(const glm::vec3 &p) const;
+	uint32_t addStyle(const glm::vec4 &color, float size);
+	void addPrimitive(PrimitiveType type, uint32_t first, uint32_t style, float minX, float minY, float maxX, float maxY);
+	void rasterizeTile(Tile &tile, float *buffer);
+
+	int canvasWidth, canvasHeight;
+	int tilesX, tilesY;
+	JobSystem *jobs;
+	GlyphAtlas atlas;
+
+	glm::vec4 clearColor {0.0f, 0.0f, 0.0f, 1.0f};
+	std::vector<glm::vec2> vertices;
+	std::vector<GlyphQuad> glyphQuads;
+	std::vector<Style> styles;
+	std::vector<Primitive> primitives;
+	std::vector<Tile> tiles;
+	std::vector<unsigned char> colorBuffer;
+};
+
+#endif